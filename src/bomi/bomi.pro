@@ -54,7 +54,7 @@ macx {
 } else:win32 {
     QT += winextras gui-private core-private
     RC_ICONS = ../../icons/bomi.ico
-    LIBS += -lopengl32 -lgdi32 -limm32 -lwinmm -lole32 -ldvdcss -lrpcrt4
+    LIBS += -lopengl32 -lgdi32 -limm32 -lwinmm -lole32 -ldvdcss -lrpcrt4 -lshell32
     HEADERS += os/win.hpp
     SOURCES += os/win.cpp
     CONFIG -= debug
@@ -301,7 +301,15 @@ HEADERS += \
     dialog/encoderdialog.hpp \
     misc/filenamegenerator.hpp \
     enum/rotation.hpp \
-    player/videosettings.hpp
+    player/videosettings.hpp \
+    video/videothumbnailcache.hpp \
+    video/videokeyframeindex.hpp \
+    video/frametiming.hpp \
+    misc/lockfreering.hpp \
+    subtitle/subtitleloader.hpp \
+    subtitle/subtitlerasterizer.hpp \
+    player/mrlprefetcher.hpp \
+    misc/startupprofiler.hpp
 
 SOURCES += \
 	stdafx.cpp \
@@ -519,7 +527,14 @@ SOURCES += \
     dialog/encoderdialog.cpp \
     misc/filenamegenerator.cpp \
     enum/rotation.cpp \
-    player/videosettings.cpp
+    player/videosettings.cpp \
+    video/videothumbnailcache.cpp \
+    video/videokeyframeindex.cpp \
+    video/frametiming.cpp \
+    subtitle/subtitleloader.cpp \
+    subtitle/subtitlerasterizer.cpp \
+    player/mrlprefetcher.cpp \
+    misc/startupprofiler.cpp
 
 TRANSLATIONS += translations/bomi_en.ts \
 	translations/bomi_ko.ts \
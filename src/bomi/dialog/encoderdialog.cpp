@@ -7,12 +7,15 @@
 #include "misc/dataevent.hpp"
 #include "misc/osdstyle.hpp"
 #include "player/streamtrack.hpp"
+#include "subtitle/subtitlerasterizer.hpp"
 #include <QCloseEvent>
 extern "C" {
 #include <libavcodec/avcodec.h>
 }
 
 static constexpr int TickEvent = QEvent::User + 1;
+// encoder is paused unless images of captions are ready for this period
+static constexpr int RasterLead = 10000;
 
 enum FrameRate { CFRAuto, CFRManual, VFR };
 
@@ -52,6 +55,10 @@ struct EncoderDialog::Data {
     QByteArray source;
     StreamTrack audio, sub;
     OsdStyle style;
+    QVector<SubComp> comps;
+    double fps = 0.0;
+    QSharedPointer<SubtitleRasterizer> raster;
+    std::atomic<int> pos{0}, end{0};
     QSize size;
     QPushButton *start = nullptr;
     FileNameGenerator g;
@@ -64,6 +71,33 @@ struct EncoderDialog::Data {
     bool resizing = false;
     auto aspect() const -> double
         { return size.isEmpty() ? 1.0 : size.width() / (double)size.height(); }
+    auto isRasterAhead() const -> bool
+    {
+        return raster->isFinished()
+            || raster->readyUntil() >= qMin(pos + RasterLead, end.load());
+    }
+    auto rasterize(const QSize &frame, int a, int b) -> bool
+    {
+        if (!ui.subtitle_raster->isChecked() || comps.isEmpty()
+                || sub.type() != StreamInclusiveSubtitle)
+            return false;
+        SubComp comp = comps.first();
+        for (int i = 1; i < comps.size(); ++i)
+            comp.unite(comps[i], fps);
+        raster.reset(new SubtitleRasterizer);
+        raster->setStyle(style);
+        raster->setFrameSize(frame);
+        raster->setFps(fps);
+        if (!raster->start(comp, a, b)) {
+            raster.clear();
+            return false;
+        }
+        QObject::connect(raster.data(), &SubtitleRasterizer::progressed, p, [=] () {
+            if (mpv && raster && isRasterAhead())
+                mpv->setAsync("pause", false);
+        });
+        return true;
+    }
 };
 
 EncoderDialog::EncoderDialog(QWidget *parent)
@@ -76,6 +110,7 @@ EncoderDialog::EncoderDialog(QWidget *parent)
     d->storage.add("fps", d->ui.fps, "currentIndex");
     d->storage.add(d->ui.fps_value);
     d->storage.add(d->ui.subtitle);
+    d->storage.add(d->ui.subtitle_raster);
     d->storage.add(d->ui.cx);
     d->storage.add(d->ui.cy);
     d->storage.add(d->ui.cw);
@@ -226,6 +261,7 @@ auto EncoderDialog::setSource(const QByteArray &mrl, const QSize &size,
     d->ui.ch->setValue(size.height());
     d->resizing = false;
     d->audio = d->sub = StreamTrack();
+    d->comps.clear();
     d->g = g;
     _SetWindowTitle(this, tr("Encoder: %1").arg(d->g.mediaName));
     updateCropArea();
@@ -276,6 +312,7 @@ auto EncoderDialog::run() -> QString
     connect(d->mpv.data(), &QThread::finished, this, [=] () {
         d->mpv->destroy();
         d->mpv.clear();
+        d->raster.clear();
         d->start->setEnabled(true);
         if (d->error != MPV_ERROR_SUCCESS)
             MBox::error(this, tr("Encoder"), QString::fromUtf8(mpv_error_string(d->error)),
@@ -287,7 +324,10 @@ auto EncoderDialog::run() -> QString
     d->mpv->setObserver(this);
     d->mpv->observe("time-pos", [=] (double s) { qDebug() << s; });
     d->mpv->request(MPV_EVENT_TICK, [=] (mpv_event*) {
-        if (_Change<int>(d->tick, d->mpv->get<double>("time-pos") * 10))
+        d->pos = d->mpv->get<double>("time-pos") * 1000;
+        if (d->raster && !d->isRasterAhead())
+            d->mpv->setAsync("pause", true);
+        if (_Change<int>(d->tick, d->pos / 100))
             _PostEvent(this, TickEvent, d->tick);
     });
     d->mpv->request(MPV_EVENT_END_FILE, [=] (mpv_event *e) {
@@ -325,6 +365,19 @@ auto EncoderDialog::run() -> QString
             vf += ',';
         vf += "scale=" + _n(size.width()) + ':' + _n(size.height());
     }
+    // images are drawn at final size and overlaid after crop and scale
+    const bool raster = d->ui.subtitle->isChecked() && d->rasterize(size, a, b);
+    if (raster) {
+        const auto graph = d->raster->filterGraph();
+        if (!vf.isEmpty())
+            vf += ',';
+        vf += "lavfi=graph=%" + _n(graph.size()) + '%' + graph;
+        d->mpv->setOption("sid", "no");
+        d->pos = a;
+        d->end = b;
+        if (!d->isRasterAhead())
+            d->mpv->setOption("pause", "yes");
+    }
     if (!vf.isEmpty())
         d->mpv->setOption("vf", vf);
 
@@ -350,7 +403,7 @@ auto EncoderDialog::run() -> QString
 
     if (!d->ui.subtitle->isChecked())
         d->mpv->setOption("sid", "no");
-    else {
+    else if (!raster) {
         const auto color = [] (const QColor &color) { return color.name(QColor::HexArgb).toLatin1(); };
         const auto &style = d->style;
         const auto &font = style.font;
@@ -440,6 +493,13 @@ auto EncoderDialog::setSubtitle(const StreamTrack &sub, const OsdStyle &style) -
     d->style = style;
 }
 
+auto EncoderDialog::setSubtitleComponents(const QVector<SubComp> &comps,
+                                          double fps) -> void
+{
+    d->comps = comps;
+    d->fps = fps;
+}
+
 auto EncoderDialog::showEvent(QShowEvent *event) -> void
 {
     QDialog::showEvent(event);
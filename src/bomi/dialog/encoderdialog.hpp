@@ -2,7 +2,7 @@
 #define ENCODERDIALOG_HPP
 
 class FileNameGenerator;                class OsdStyle;
-class StreamTrack;
+class StreamTrack;                      class SubComp;
 
 class EncoderDialog : public QDialog {
     Q_OBJECT
@@ -14,6 +14,8 @@ public:
     auto setRange(int start, int end) -> void;
     auto setAudio(const StreamTrack &audio) -> void;
     auto setSubtitle(const StreamTrack &sub, const OsdStyle &style) -> void;
+    // components parsed by bomi, drawn by bomi if selected
+    auto setSubtitleComponents(const QVector<SubComp> &comps, double fps) -> void;
     auto start() -> bool;
     auto cancel() -> void;
     auto cropArea() const -> QRect;
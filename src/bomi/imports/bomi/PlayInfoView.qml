@@ -15,7 +15,8 @@ Item {
         from: 0.0; to: 1.0; easing { type: Easing.OutBack; overshoot: 1.1 }
     }
 
-    Component.onCompleted: { bringIn.start() }
+    Component.onCompleted: { bringIn.start(); engine.watchStatistics(true) }
+    Component.onDestruction: engine.watchStatistics(false)
 
     ColumnLayout {
         id: box; spacing: 0
@@ -146,5 +147,20 @@ Item {
 //                onItemChanged: { if (item) item.info = modelData }
             }
         }
+
+        PlayInfoText { }
+
+        Repeater {
+            model: engine.hookLatencies
+            PlayInfoText {
+                content: qsTr("Hook %1: Avg=%2ms, P95=%3ms, Max=%4ms, Exec=%5ms (%6 runs)")
+                    .arg(modelData.name)
+                    .arg(Format.fixedNA(modelData.average, 2, 0))
+                    .arg(Format.fixedNA(modelData.p95, 2, 0))
+                    .arg(Format.fixedNA(modelData.max, 2, 0))
+                    .arg(Format.fixedNA(modelData.execution, 2, 0))
+                    .arg(modelData.count)
+            }
+        }
     }
 }
@@ -72,8 +72,7 @@ auto CharsetDetector::detect(const QString &fileName, double confidence, int siz
         return EncodingInfo();
     }
     _Info("Trying encoding autodetection: %%", fileName);
-    size = -1;
-    if (size < 0)
+    if (size < 0 || size > file.size())
         size = file.size();
     return detect(file.read(size), confidence);
 }
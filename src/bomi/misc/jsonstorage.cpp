@@ -174,6 +174,30 @@ static auto convs() -> const QHash<int, JVConvert>&
         INSERT(WindowSize);
         INSERT(QList<WindowSize>);
 
+        // generic values such as reports returned to JSON-RPC clients
+        c[QMetaType::QVariantMap] = {
+            [] (const JVConvert*, const QJsonValue &j, QVariant &var) -> bool {
+                if (!j.isObject())
+                    return false;
+                var = j.toObject().toVariantMap();
+                return true;
+            },
+            [] (const JVConvert*, const QVariant &v) -> QJsonValue {
+                return QJsonValue::fromVariant(v);
+            }, QVariantMap(), QJsonValue::Object, {}, QMetaType::QVariantMap
+        };
+        c[QMetaType::QVariantList] = {
+            [] (const JVConvert*, const QJsonValue &j, QVariant &var) -> bool {
+                if (!j.isArray())
+                    return false;
+                var = j.toArray().toVariantList();
+                return true;
+            },
+            [] (const JVConvert*, const QVariant &v) -> QJsonValue {
+                return QJsonValue::fromVariant(v);
+            }, QVariantList(), QJsonValue::Array, {}, QMetaType::QVariantList
+        };
+
         for (auto type : _EnumMetaTypeIds()) {
             auto &ec = c[type];
             ec.enum_ = _EnumNameVariantConverter(type);
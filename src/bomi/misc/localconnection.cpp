@@ -2,6 +2,8 @@
 #include <QLocalServer>
 #include <QLockFile>
 #include <QLocalSocket>
+#include <QElapsedTimer>
+#include <QtEndian>
 
 #if defined(Q_OS_WIN)
 #include <QtCore/QLibrary>
@@ -11,6 +13,9 @@ static PProcessIdToSessionId pProcessIdToSessionId = 0;
 #endif
 #if defined(Q_OS_UNIX)
 #include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #endif
 
 static int getUid() {
@@ -30,18 +35,117 @@ static int getUid() {
 #endif
 }
 
+static auto serverName(const QString &id) -> QString
+{
+    return id % '-'_q % QString::number(getUid(), 16);
+}
+
+// message is framed by its size in big endian and answered by ack or nak
+constexpr static const char* ack = "ack";
+constexpr static const char* nak = "nak";
+constexpr static const int ReplySize = 3;
+constexpr static const quint32 MaxMessageSize = 1024 * 1024;
+
+static auto frame(const QByteArray &message) -> QByteArray
+{
+    QByteArray data(sizeof(quint32), Qt::Uninitialized);
+    qToBigEndian<quint32>(message.size(), (uchar*)data.data());
+    return data + message;
+}
+
+#if defined(Q_OS_WIN)
+static auto send(const QString &name, const QByteArray &data, int timeout) -> bool
+{
+    const auto pipe = QString(u"\\\\.\\pipe\\"_q % name).toStdWString();
+    if (!WaitNamedPipeW(pipe.c_str(), timeout))
+        return false;
+    auto handle = CreateFileW(pipe.c_str(), GENERIC_READ | GENERIC_WRITE, 0,
+                              nullptr, OPEN_EXISTING, 0, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+    QByteArray reply;
+    DWORD written = 0;
+    if (WriteFile(handle, data.constData(), data.size(), &written, nullptr)
+            && (int)written == data.size()) {
+        // ReadFile() has no timeout for synchronous pipe
+        QElapsedTimer timer;
+        timer.start();
+        DWORD available = 0;
+        while (PeekNamedPipe(handle, nullptr, 0, nullptr, &available, nullptr)
+               && (int)available < ReplySize && timer.elapsed() < timeout)
+            Sleep(1);
+        DWORD read = 0;
+        reply.resize(ReplySize);
+        if ((int)available < ReplySize
+                || !ReadFile(handle, reply.data(), ReplySize, &read, nullptr))
+            read = 0;
+        reply.resize(read);
+    }
+    CloseHandle(handle);
+    return reply == ack;
+}
+#else
+static auto send(const QString &name, const QByteArray &data, int timeout) -> bool
+{
+    // QLocalServer puts relative name in temporary directory
+    const auto path = QFile::encodeName(QDir::tempPath() % '/'_q % name);
+    sockaddr_un addr;
+    if (path.size() >= (int)sizeof(addr.sun_path))
+        return false;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.constData(), path.size());
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return false;
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags = MSG_NOSIGNAL;
+#elif defined(SO_NOSIGPIPE)
+    const int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    QByteArray reply;
+    if (!::connect(fd, (sockaddr*)&addr, sizeof(addr))) {
+        int sent = 0;
+        while (sent < data.size()) {
+            const auto n = ::send(fd, data.constData() + sent, data.size() - sent, flags);
+            if (n <= 0)
+                break;
+            sent += n;
+        }
+        pollfd pfd{fd, POLLIN, 0};
+        reply.resize(ReplySize);
+        int read = 0;
+        QElapsedTimer timer;
+        timer.start();
+        while (sent == data.size() && read < ReplySize) {
+            const int left = timeout - timer.elapsed();
+            if (left <= 0 || ::poll(&pfd, 1, left) <= 0)
+                break;
+            const auto n = ::read(fd, reply.data() + read, ReplySize - read);
+            if (n <= 0)
+                break;
+            read += n;
+        }
+        reply.resize(read);
+    }
+    ::close(fd);
+    return reply == ack;
+}
+#endif
+
 struct LocalConnection::Data {
     QString id, socket;
     QLocalServer server;
     QLockFile *lock = nullptr;
+    bool accepting = true;
 };
 
-constexpr static const char* ack = "ack";
-
 LocalConnection::LocalConnection(const QString &id, QObject* parent)
 : QObject(parent), d(new Data) {
     d->id = id;
-    d->socket = id % '-'_q % QString::number(getUid(), 16);
+    d->socket = serverName(id);
     d->lock = new QLockFile(QDir::temp().path() % '/'_q % d->socket % u"-lock"_q);
     d->lock->setStaleLockTime(0);
 }
@@ -62,28 +166,34 @@ auto LocalConnection::runServer() -> bool
         if (!d->server.listen(d->socket))
             return false;
     }
-    connect(&d->server, &QLocalServer::newConnection, [this]() {
-        QScopedPointer<QLocalSocket> socket(d->server.nextPendingConnection());
-        if (socket) {
-            while (socket->bytesAvailable() < (int)sizeof(quint32))
-                socket->waitForReadyRead();
-            QDataStream in(socket.data());
-            QByteArray msg;
-            quint32 left;
-            in >> left;
-            msg.resize(left);
-            char *buffer = msg.data();
-            do {
-                const int read = in.readRawData(buffer, left);
-                if (read < 0)
+    connect(&d->server, &QLocalServer::newConnection, this, [this]() {
+        while (auto socket = d->server.nextPendingConnection()) {
+            connect(socket, &QLocalSocket::disconnected,
+                    socket, &QLocalSocket::deleteLater);
+            auto buffer = QSharedPointer<QByteArray>::create();
+            auto read = [=] () {
+                *buffer += socket->readAll();
+                if (buffer->size() < (int)sizeof(quint32))
                     return;
-                left -= read;
-                buffer += read;
-            } while (left > 0 && socket->waitForReadyRead(5000));
-            socket->write(ack, qstrlen(ack));
-            socket->waitForBytesWritten(1000);
-            socket->close();
-            emit messageReceived(msg); //### (might take a long time to return)
+                const auto size = qFromBigEndian<quint32>((const uchar*)buffer->constData());
+                if (size > MaxMessageSize) {
+                    socket->abort();
+                    socket->deleteLater();
+                    return;
+                }
+                if ((quint32)buffer->size() < sizeof(quint32) + size)
+                    return;
+                const auto msg = buffer->mid(sizeof(quint32), size);
+                const bool accepted = d->accepting;
+                socket->write(accepted ? ack : nak, ReplySize);
+                // pending reply is written before disconnected
+                socket->disconnectFromServer();
+                if (accepted)
+                    emit messageReceived(msg);
+            };
+            connect(socket, &QLocalSocket::readyRead, this, read);
+            if (socket->bytesAvailable() > 0)
+                read();
         }
     });
     return true;
@@ -93,14 +203,16 @@ auto LocalConnection::sendMessage(const QByteArray &msg, int timeout) -> bool
 {
     if (runServer())
         return false;
-    QLocalSocket socket;
-    socket.connectToServer(d->socket);
-    if (!socket.waitForConnected(timeout))
-        return false;
-    QDataStream out(&socket);
-    out.writeBytes(msg.constData(), msg.size());
-    bool res = socket.waitForBytesWritten(timeout);
-    res &= socket.waitForReadyRead(timeout);   // wait for ack
-    res &= (socket.read(qstrlen(ack)) == ack);
-    return res;
+    return send(d->socket, frame(msg), timeout);
+}
+
+auto LocalConnection::setAccepting(bool accepting) -> void
+{
+    d->accepting = accepting;
+}
+
+auto LocalConnection::forward(const QString &id, const QByteArray &message,
+                              int timeout) -> bool
+{
+    return send(serverName(id), frame(message), timeout);
 }
@@ -8,6 +8,12 @@ public:
     ~LocalConnection();
     auto runServer() -> bool;
     auto sendMessage(const QByteArray &message, int timeout) -> bool;
+    // server rejects messages while not accepting them
+    auto setAccepting(bool accepting) -> void;
+    // send message to the server of id through native socket, usable even
+    // before QCoreApplication is created; true if the server accepted it
+    static auto forward(const QString &id, const QByteArray &message,
+                        int timeout) -> bool;
 signals:
     void messageReceived(const QByteArray &message);
 private:
@@ -0,0 +1,49 @@
+#ifndef LOCKFREERING_HPP
+#define LOCKFREERING_HPP
+
+#include <atomic>
+#include <array>
+
+// single producer, single consumer ring without locks.
+// push() never blocks: when the consumer falls behind, new items are dropped.
+template<class T, int N>
+class LockFreeRing {
+    static_assert(N > 0 && !(N & (N - 1)), "N must be a power of 2");
+public:
+    auto push(const T &t) -> bool
+    {
+        const auto w = m_write.load(std::memory_order_relaxed);
+        if (w - m_read.load(std::memory_order_acquire) >= (quint32)N) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_items[w & (N - 1)] = t;
+        m_write.store(w + 1, std::memory_order_release);
+        return true;
+    }
+    auto pop(T &t) -> bool
+    {
+        const auto r = m_read.load(std::memory_order_relaxed);
+        if (r == m_write.load(std::memory_order_acquire))
+            return false;
+        t = m_items[r & (N - 1)];
+        m_read.store(r + 1, std::memory_order_release);
+        return true;
+    }
+    template<class F>
+    auto drain(F &&func) -> int
+    {
+        int count = 0; T t;
+        for (; pop(t); ++count)
+            func(t);
+        return count;
+    }
+    auto dropped() const -> quint32
+        { return m_dropped.load(std::memory_order_relaxed); }
+    static constexpr auto capacity() -> int { return N; }
+private:
+    std::array<T, N> m_items;
+    std::atomic<quint32> m_write{0}, m_read{0}, m_dropped{0};
+};
+
+#endif // LOCKFREERING_HPP
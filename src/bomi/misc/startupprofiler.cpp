@@ -0,0 +1,81 @@
+#include "startupprofiler.hpp"
+#include <QElapsedTimer>
+#include <cstdio>
+
+struct StartupData {
+    StartupData() { clock.start(); }
+    QElapsedTimer clock;
+    QMutex mutex;
+    QVector<StartupProfiler::Phase> phases;
+    bool dump = false, finished = false;
+};
+
+// constructed by the first mark, which is the closest to process start
+static auto data() -> StartupData&
+{
+    static StartupData d;
+    return d;
+}
+
+auto StartupProfiler::mark(const char *name) -> void
+{
+    auto &d = data();
+    const auto time = d.clock.nsecsElapsed();
+    QMutexLocker locker(&d.mutex);
+    if (!d.finished)
+        d.phases.push_back({ name, time });
+}
+
+auto StartupProfiler::setDumpRequested(bool dump) -> void
+{
+    auto &d = data();
+    QMutexLocker locker(&d.mutex);
+    d.dump = dump;
+}
+
+auto StartupProfiler::finish(const char *name) -> void
+{
+    auto &d = data();
+    mark(name);
+    bool dump = false;
+    {
+        QMutexLocker locker(&d.mutex);
+        if (d.finished)
+            return;
+        d.finished = true;
+        dump = d.dump;
+    }
+    if (dump)
+        StartupProfiler::dump();
+}
+
+auto StartupProfiler::isFinished() -> bool
+{
+    auto &d = data();
+    QMutexLocker locker(&d.mutex);
+    return d.finished;
+}
+
+auto StartupProfiler::phases() -> QVector<Phase>
+{
+    auto &d = data();
+    QMutexLocker locker(&d.mutex);
+    return d.phases;
+}
+
+auto StartupProfiler::dump() -> void
+{
+    const auto phases = StartupProfiler::phases();
+    int width = 0;
+    for (auto &phase : phases)
+        width = qMax(width, (int)qstrlen(phase.name));
+    // stdout as promised by --startup-profile, not qDebug() which goes to stderr
+    std::printf("Startup profile (ms since start, ms spent in phase):\n");
+    qint64 prev = 0;
+    for (auto &phase : phases) {
+        std::printf("  %-*s %9.2f %9.2f\n", width, phase.name,
+                    phase.time * 1e-6, (phase.time - prev) * 1e-6);
+        prev = phase.time;
+    }
+    std::fflush(stdout);
+}
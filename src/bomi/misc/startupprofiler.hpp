@@ -0,0 +1,19 @@
+#ifndef STARTUPPROFILER_HPP
+#define STARTUPPROFILER_HPP
+
+// Records named phases of startup with monotonic time since the process
+// started. Marking is cheap enough to be always on; the table is dumped only
+// when requested. Marks after finish() are ignored.
+class StartupProfiler {
+public:
+    struct Phase { const char *name; qint64 time; }; // time in ns
+    static auto mark(const char *name) -> void;
+    static auto setDumpRequested(bool dump) -> void;
+    // mark last phase and dump the table if requested
+    static auto finish(const char *name) -> void;
+    static auto isFinished() -> bool;
+    static auto phases() -> QVector<Phase>;
+    static auto dump() -> void;
+};
+
+#endif // STARTUPPROFILER_HPP
@@ -1,18 +1,206 @@
 #include "openglbenchmarker.hpp"
 #include "misc/log.hpp"
+#include <QOpenGLTimerQuery>
+#include <deque>
 
 DECLARE_LOG_CONTEXT(OpenGL)
 
-void OpenGLBenchmarker::end()
+static constexpr const int QuerySlots = 64;
+static constexpr const int Recent = 64;
+
+struct OpenGLBenchmarker::Data {
+    struct Flight { quint64 ticket; int slot; Scope scope; };
+    struct Accum { int count = 0; qint64 total = 0, max = 0; };
+    bool created = false, gpu = false;
+    QOpenGLTimerQuery *queries[QuerySlots][2] = {};
+    QVector<int> free;
+    int open[ScopeCount];
+    qint64 start[ScopeCount];
+    std::deque<Flight> flights;
+    quint64 ticket = 0, completed = 0;
+    QPair<quint64, qint64> recent[Recent];
+    Accum accum[ScopeCount];
+    int frames = 0, interval = 600, missed = 0;
+    QElapsedTimer clock;
+    mutable QMutex mutex;
+    QVector<Result> results{ScopeCount};
+
+    auto finish(quint64 ticket, Scope scope, qint64 ns) -> void
+    {
+        recent[ticket % Recent] = qMakePair(ticket, ns);
+        completed = ticket;
+        auto &a = accum[scope];
+        ++a.count;
+        a.total += ns;
+        a.max = qMax(a.max, ns);
+    }
+    auto report() -> void
+    {
+        QVector<Result> results(ScopeCount);
+        for (int i = 0; i < ScopeCount; ++i) {
+            auto &a = accum[i];
+            auto &r = results[i];
+            r.count = a.count;
+            if (a.count > 0) {
+                r.average = a.total * 1e-6 / a.count;
+                r.max = a.max * 1e-6;
+                _Debug("%%: %%ms average, %%ms max for %% passes in %% frames",
+                       scopeName((Scope)i), r.average, r.max, r.count, frames);
+            }
+            a = Accum();
+        }
+        if (missed > 0)
+            _Debug("%% passes were not measured due to lack of queries", missed);
+        frames = missed = 0;
+        QMutexLocker locker(&mutex);
+        this->results = results;
+    }
+};
+
+OpenGLBenchmarker::OpenGLBenchmarker()
+    : d(new Data)
+{
+    d->clock.start();
+    std::fill_n(d->open, (int)ScopeCount, -1);
+}
+
+OpenGLBenchmarker::~OpenGLBenchmarker()
+{
+    delete d;
+}
+
+auto OpenGLBenchmarker::instance() -> OpenGLBenchmarker&
+{
+    static OpenGLBenchmarker obj;
+    return obj;
+}
+
+auto OpenGLBenchmarker::scopeName(Scope scope) -> const char*
 {
-    m_timer.end();
-    m_ns += m_timer.waitForResult();
-    ++m_counter;
-    if (m_counter >= m_max) {
-        _Info("%%op/s (%%ms for %% operations)",
-              m_counter/(m_ns*1e-9),
-              m_ns/1000000.0, m_counter);
-        m_counter = 0;
-        m_ns = 0;
+    switch (scope) {
+    case Frame:     return "frame";
+    case Video:     return "video";
+    case Osd:       return "osd";
+    case Subtitle:  return "subtitle";
+    case Letterbox: return "letterbox";
+    case Preview:   return "preview";
+    default:        return "";
     }
 }
+
+auto OpenGLBenchmarker::create() -> void
+{
+    if (d->created)
+        return;
+    d->gpu = true;
+    for (auto &slot : d->queries) {
+        for (auto &query : slot) {
+            query = new QOpenGLTimerQuery;
+            d->gpu = d->gpu && query->create();
+        }
+    }
+    if (!d->gpu) {
+        for (auto &slot : d->queries) {
+            for (auto &query : slot)
+                _Delete(query);
+        }
+        _Info("Timer query is not supported. CPU time will be measured.");
+    }
+    d->free.clear();
+    for (int i = QuerySlots - 1; i >= 0; --i)
+        d->free.push_back(i);
+    d->created = true;
+}
+
+auto OpenGLBenchmarker::destroy() -> void
+{
+    for (auto &slot : d->queries) {
+        for (auto &query : slot)
+            _Delete(query);
+    }
+    d->flights.clear();
+    d->free.clear();
+    std::fill_n(d->open, (int)ScopeCount, -1);
+    d->created = d->gpu = false;
+}
+
+auto OpenGLBenchmarker::isCreated() const -> bool
+{
+    return d->created;
+}
+
+auto OpenGLBenchmarker::isGpuTimer() const -> bool
+{
+    return d->gpu;
+}
+
+auto OpenGLBenchmarker::begin(Scope scope) -> void
+{
+    if (!d->created)
+        return;
+    if (!d->gpu) {
+        d->start[scope] = d->clock.nsecsElapsed();
+        d->open[scope] = 0;
+    } else if (d->free.isEmpty()) {
+        ++d->missed;
+    } else if (d->open[scope] < 0) {
+        d->open[scope] = d->free.takeLast();
+        d->queries[d->open[scope]][0]->recordTimestamp();
+    }
+}
+
+auto OpenGLBenchmarker::end(Scope scope) -> quint64
+{
+    const int slot = d->open[scope];
+    if (slot < 0)
+        return 0;
+    d->open[scope] = -1;
+    const auto ticket = ++d->ticket;
+    if (!d->gpu)
+        d->finish(ticket, scope, d->clock.nsecsElapsed() - d->start[scope]);
+    else {
+        d->queries[slot][1]->recordTimestamp();
+        d->flights.push_back({ticket, slot, scope});
+    }
+    return ticket;
+}
+
+auto OpenGLBenchmarker::collect() -> void
+{
+    if (!d->created)
+        return;
+    while (!d->flights.empty()) {
+        const auto &f = d->flights.front();
+        auto q = d->queries[f.slot];
+        if (!q[1]->isResultAvailable())
+            break;
+        const qint64 ns = q[1]->waitForResult() - q[0]->waitForResult();
+        d->finish(f.ticket, f.scope, ns);
+        d->free.push_back(f.slot);
+        d->flights.pop_front();
+    }
+    if (++d->frames >= d->interval)
+        d->report();
+}
+
+auto OpenGLBenchmarker::completed() const -> quint64
+{
+    return d->completed;
+}
+
+auto OpenGLBenchmarker::elapsed(quint64 ticket) const -> qint64
+{
+    const auto &r = d->recent[ticket % Recent];
+    return r.first == ticket ? r.second : -1;
+}
+
+auto OpenGLBenchmarker::setReportInterval(int frames) -> void
+{
+    d->interval = qMax(1, frames);
+}
+
+auto OpenGLBenchmarker::results() const -> QVector<Result>
+{
+    QMutexLocker locker(&d->mutex);
+    return d->results;
+}
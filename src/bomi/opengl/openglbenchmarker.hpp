@@ -1,25 +1,40 @@
 #ifndef OPENGLBENCHMARKER_HPP
 #define OPENGLBENCHMARKER_HPP
 
-#include <QOpenGLTimerQuery>
-
+// Non-blocking GPU profiler for render thread.
+// Timestamps are recorded around named scopes and read back frames later
+// by collect(), so nothing waits for the GPU. Without timer query support,
+// CPU time of each scope is measured instead.
 class OpenGLBenchmarker {
 public:
-    OpenGLBenchmarker() = default;
-    OpenGLBenchmarker(bool init) { if (init) create(); }
-    void create() {
-        m_timer.create();
-        m_ns = 0;
-        m_counter = 0;
-    }
-    void destroy() { m_timer.destroy(); }
-    void begin() { m_timer.begin(); }
-    void end();
-    void setMaxCount(int n) { m_max = n; }
+    enum Scope { Frame, Video, Osd, Subtitle, Letterbox, Preview, ScopeCount };
+    struct Result {
+        int count = 0;
+        double average = 0.0, max = 0.0; // in ms
+    };
+    static auto instance() -> OpenGLBenchmarker&;
+    static auto scopeName(Scope scope) -> const char*;
+    auto create() -> void;
+    auto destroy() -> void;
+    auto isCreated() const -> bool;
+    auto isGpuTimer() const -> bool;
+    auto begin(Scope scope) -> void;
+    // returns ticket to query the result later, 0 if not measured
+    auto end(Scope scope) -> quint64;
+    // read back finished queries; call once per frame
+    auto collect() -> void;
+    auto completed() const -> quint64;
+    // in ns, -1 if not available anymore
+    auto elapsed(quint64 ticket) const -> qint64;
+    // results are aggregated and reported every n frames
+    auto setReportInterval(int frames) -> void;
+    // last report, can be called in any thread
+    auto results() const -> QVector<Result>;
 private:
-    QOpenGLTimerQuery m_timer;
-    quint64 m_ns = 0;
-    int m_counter = 0, m_max = 100;
+    OpenGLBenchmarker();
+    ~OpenGLBenchmarker();
+    struct Data;
+    Data *d;
 };
 
 #endif // OPENGLBENCHMARKER_HPP
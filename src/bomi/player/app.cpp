@@ -6,6 +6,7 @@
 #include "misc/json.hpp"
 #include "misc/locale.hpp"
 #include "misc/objectstorage.hpp"
+#include "misc/startupprofiler.hpp"
 #include "quick/appobject.hpp"
 #include "rootmenu.hpp"
 #include "os/os.hpp"
@@ -22,6 +23,11 @@
 #include "player/mpris.hpp"
 #endif
 
+#ifdef Q_OS_WIN
+#include <QtCore/qt_windows.h>
+#include <shellapi.h>
+#endif
+
 #ifdef main
 #undef main
 #endif
@@ -42,7 +48,7 @@ auto translator_load(const Locale &locale) -> bool;
 enum class LineCmd {
     Wake, Open, Action, LogLevel, Debug,
     DumpApiTree, DumpActionList, WinAssoc, WinUnassoc, WinAssocDefault,
-    SetSubtitle, AddSubtitle,
+    SetSubtitle, AddSubtitle, StartupProfile, EagerInit,
 };
 
 static const QCommandLineOption s_dummy{u"__dummy__"_q};
@@ -50,20 +56,33 @@ static const QCommandLineOption s_dummy{u"__dummy__"_q};
 class CommandParser {
 public:
     CommandParser();
-    auto addOption(LineCmd cmd, const QString &name, const QString &desc,
-                   const QString &valName = QString(),
-                   const QString &def = QString()) -> void
-        { addOption(cmd, QStringList(name), desc, valName, def); }
     auto option(LineCmd cmd) const -> QCommandLineOption { return m_options.value(cmd, s_dummy); }
     auto isSet(LineCmd cmd) const -> bool { return m_parser.isSet(option(cmd)); }
     auto value(LineCmd cmd) const -> QString  { return m_parser.value(option(cmd)); }
     auto values(LineCmd cmd) const -> QStringList { return m_parser.values(option(cmd)); }
     auto parse(const QStringList &args) -> void { m_parser.process(args); }
+    // no exit on error, for use before QCoreApplication is created
+    auto tryParse(const QStringList &args) -> bool { return m_parser.parse(args); }
     auto name(LineCmd cmd) const -> QString { return option(cmd).names().first(); }
-    auto toJson() const -> QJsonArray
+    // true if running instance can handle all given options
+    auto isForwardable() const -> bool
+    {
+        static const QVector<LineCmd> cmds = {
+            LineCmd::Wake, LineCmd::Open, LineCmd::Action,
+            LineCmd::SetSubtitle, LineCmd::AddSubtitle
+        };
+        for (auto &name : m_parser.optionNames()) {
+            auto pred = [&] (LineCmd cmd) { return option(cmd).names().contains(name); };
+            if (std::none_of(cmds.begin(), cmds.end(), pred))
+                return false;
+        }
+        return true;
+    }
+    // arguments to be parsed in running instance with absolute paths
+    auto arguments(const QString &program) const -> QStringList
     {
         QStringList args;
-        args.push_back(qApp->applicationFilePath());
+        args.push_back(program);
         auto put = [&] (LineCmd cmd) {
             if (!isSet(cmd)) return false;
             args.push_back("--"_a % name(cmd)); return true;
@@ -78,7 +97,7 @@ public:
         const auto mrl = this->mrl();
         if (!mrl.isEmpty())
             args.push_back(mrl.toString());
-        return _ToJson(args);
+        return args;
     }
     auto stdoutLogLevel() const -> Log::Level
     {
@@ -96,6 +115,10 @@ public:
         return list.isEmpty() ? Mrl() : Mrl(list.first());
     }
 private:
+    auto addOption(LineCmd cmd, const QString &name, const QString &desc,
+                   const QString &valName = QString(),
+                   const QString &def = QString()) -> void
+        { addOption(cmd, QStringList(name), desc, valName, def); }
     auto addOption(LineCmd cmd, const QStringList &names, const QString &desc,
                    const QString &valName = QString(),
                    const QString &def = QString()) -> void;
@@ -109,6 +132,37 @@ CommandParser::CommandParser()
     m_parser.addVersionOption();
     const auto desc = u"The file path or URL to open."_q;
     m_parser.addPositionalArgument(u"mrl"_q, desc, u"mrl"_q);
+    addOption(LineCmd::Open, u"open"_q,
+              u"Open given %1 for file path or URL."_q, u"mrl"_q);
+    addOption(LineCmd::SetSubtitle, u"set-subtitle"_q,
+              u"Set subtitle file to display."_q, u"file"_q);
+//    addOption(LineCmd::AddSubtitle, u"add-subtitle"_q,
+//              u"Add subtitle file to display."_q, u"file"_q);
+    addOption(LineCmd::Wake, u"wake"_q,
+              u"Bring the application window in front."_q);
+    addOption(LineCmd::Action, u"action"_q,
+              u"Exectute %1 action or open %1 menu."_q, u"id"_q);
+    addOption(LineCmd::LogLevel, u"log-level"_q,
+              u"Maximum verbosity for log. %1 should be one of nexts:\n    "_q
+              % Log::levelNames().join(u", "_q), u"lv"_q);
+    addOption(LineCmd::Debug, u"debug"_q,
+              u"Turn on options for debugging."_q);
+    addOption(LineCmd::DumpApiTree, u"dump-api-tree"_q,
+              u"Dump API structure tree to stdout."_q);
+    addOption(LineCmd::DumpActionList, u"dump-action-list"_q,
+              u"Dump executable action list to stdout."_q);
+    addOption(LineCmd::StartupProfile, u"startup-profile"_q,
+              u"Dump time spent in each phase of startup to stdout."_q);
+    addOption(LineCmd::EagerInit, u"eager-init"_q,
+              u"Initialize all subsystems before the first frame is shown."_q);
+#ifdef Q_OS_WIN
+    addOption(LineCmd::WinAssoc, u"win-assoc"_q,
+              u"Associate given comma-separated extension list."_q, u"ext"_q);
+    addOption(LineCmd::WinUnassoc, u"win-unassoc"_q,
+              u"Unassociate all extensions."_q);
+    addOption(LineCmd::WinAssocDefault, u"win-assoc-default"_q,
+              u"Associate default extensions."_q);
+#endif
 }
 
 auto CommandParser::addOption(LineCmd cmd, const QStringList &names, const QString &desc,
@@ -120,8 +174,20 @@ auto CommandParser::addOption(LineCmd cmd, const QStringList &names, const QStri
         m_parser.addOption(*m_options.insert(cmd, QCommandLineOption{ names, desc, valName, def }));
 }
 
+static const QString ConnectionId = u"net.xylosper.bomi"_q;
+
+// command line is sent as type byte followed by arguments in UTF-8, each
+// terminated by null, which cannot be confused with JSON message
+static auto encodeMessage(App::MessageType type, const QStringList &args) -> QByteArray
+{
+    QByteArray message(1, (char)type);
+    for (auto &arg : args)
+        message += arg.toUtf8() + '\0';
+    return message;
+}
+
 struct App::Data {
-    Data(App *p): p(p), connection(_L("net.xylosper.bomi"), nullptr) {}
+    Data(App *p): p(p), connection(ConnectionId, nullptr) {}
 
     App *p = nullptr;
     bool gldebug = false;
@@ -237,35 +303,10 @@ App::App(int &argc, char **argv)
     OS::initialize();
 
     _New(d->parser);
-    d->parser->addOption(LineCmd::Open, u"open"_q,
-                         u"Open given %1 for file path or URL."_q, u"mrl"_q);
-    d->parser->addOption(LineCmd::SetSubtitle, u"set-subtitle"_q,
-                         u"Set subtitle file to display."_q, u"file"_q);
-//    d->parser->addOption(LineCmd::AddSubtitle, u"add-subtitle"_q,
-//                         u"Add subtitle file to display."_q, u"file"_q);
-    d->parser->addOption(LineCmd::Wake, u"wake"_q,
-                         u"Bring the application window in front."_q);
-    d->parser->addOption(LineCmd::Action, u"action"_q,
-                         u"Exectute %1 action or open %1 menu."_q, u"id"_q);
-    d->parser->addOption(LineCmd::LogLevel, u"log-level"_q,
-                         u"Maximum verbosity for log. %1 should be one of nexts:\n    "_q
-                         % Log::levelNames().join(u", "_q), u"lv"_q);
-    d->parser->addOption(LineCmd::Debug, u"debug"_q,
-                         u"Turn on options for debugging."_q);
-    d->parser->addOption(LineCmd::DumpApiTree, u"dump-api-tree"_q,
-                         u"Dump API structure tree to stdout."_q);
-    d->parser->addOption(LineCmd::DumpActionList, u"dump-action-list"_q,
-                         u"Dump executable action list to stdout."_q);
-#ifdef Q_OS_WIN
-    d->parser->addOption(LineCmd::WinAssoc, u"win-assoc"_q,
-                         u"Associate given comma-separated extension list."_q, u"ext"_q);
-    d->parser->addOption(LineCmd::WinUnassoc, u"win-unassoc"_q,
-                         u"Unassociate all extensions."_q);
-    d->parser->addOption(LineCmd::WinAssocDefault, u"win-assoc-default"_q,
-                         u"Associate default extensions."_q);
-#endif
     d->parser->parse(arguments());
     d->gldebug = d->parser->isSet(LineCmd::Debug);
+    StartupProfiler::setDumpRequested(d->parser->isSet(LineCmd::StartupProfile));
+    StartupProfiler::mark("parse-command-line");
     const auto lvStdOut = d->parser->stdoutLogLevel();
 
     d->import();
@@ -279,8 +320,11 @@ App::App(int &argc, char **argv)
     d->storage.add("font");
     d->storage.add("fixedFont");
     d->storage.restore();
+    d->connection.setAccepting(d->unique);
+    StartupProfiler::mark("restore-app-settings");
 
     setLocale(d->locale);
+    StartupProfiler::mark("load-translator");
 
     auto logOption = d->logOption;
     if (logOption.level(LogOutput::StdOut) < lvStdOut)
@@ -314,6 +358,7 @@ App::App(int &argc, char **argv)
         setStyle(QStyleFactory::create(name));
     };
     makeStyle();
+    StartupProfiler::mark("create-style");
     connect(&d->connection, &LocalConnection::messageReceived,
             this, &App::handleMessage);
 }
@@ -352,7 +397,7 @@ auto App::executeToQuit() -> bool
         OS::associateFileTypes(nullptr, true, _CommonExtList(VideoExt | AudioExt));
     if (isSet(LineCmd::WinUnassoc))
         OS::unassociateFileTypes(nullptr, true);
-    if (isUnique() && sendMessage(CommandLine, d->parser->toJson())) {
+    if (isUnique() && sendMessage(CommandLine, d->parser->arguments(applicationFilePath()))) {
         done = true;
         _Info("Another instance of bomi is already running. Exit this...");
     }
@@ -371,6 +416,15 @@ auto App::load() -> void
 
 auto App::handleMessage(const QByteArray &message) -> void
 {
+    if (!message.isEmpty() && message[0] == (char)CommandLine) {
+        QStringList args;
+        for (auto &arg : message.mid(1).split('\0'))
+            args.push_back(QString::fromUtf8(arg));
+        args.removeLast(); // after last terminator
+        d->parser->parse(args);
+        runCommands();
+        return;
+    }
     QJsonParseError error;
     const auto msg = QJsonDocument::fromJson(message, &error).object();
     Q_ASSERT(!error.error);
@@ -393,6 +447,11 @@ auto App::isOpenGLDebugLoggerRequested() const -> bool
     return d->gldebug;
 }
 
+auto App::isEagerInitRequested() const -> bool
+{
+    return d->parser->isSet(LineCmd::EagerInit);
+}
+
 auto App::setMainWindow(MainWindow *mw) -> void
 {
     d->main = mw;
@@ -508,6 +567,35 @@ auto App::sendMessage(MessageType type, const QJsonValue &json, int timeout) ->
     return d->connection.sendMessage(QJsonDocument(message).toJson(), timeout);
 }
 
+auto App::sendMessage(MessageType type, const QStringList &args, int timeout) -> bool
+{
+    return d->connection.sendMessage(encodeMessage(type, args), timeout);
+}
+
+auto App::forwardCommandLine(int argc, char **argv) -> bool
+{
+    QStringList args;
+#ifdef Q_OS_WIN
+    Q_UNUSED(argc); Q_UNUSED(argv);
+    int count = 0;
+    if (auto wargv = CommandLineToArgvW(GetCommandLineW(), &count)) {
+        for (int i = 0; i < count; ++i)
+            args.push_back(QString::fromWCharArray(wargv[i]));
+        LocalFree(wargv);
+    }
+#else
+    // locale for file names, which QCoreApplication would set anyway
+    setlocale(LC_ALL, "");
+    for (int i = 0; i < argc; ++i)
+        args.push_back(QString::fromLocal8Bit(argv[i]));
+#endif
+    CommandParser parser;
+    if (!parser.tryParse(args) || !parser.isForwardable())
+        return false;
+    const auto message = encodeMessage(CommandLine, parser.arguments(args.first()));
+    return LocalConnection::forward(ConnectionId, message, 1000);
+}
+
 auto App::setLocale(const Locale &locale) -> void
 {
     if (translator_load(locale))
@@ -555,6 +643,7 @@ auto App::setStyleName(const QString &name) -> void
 auto App::setUnique(bool unique) -> void
 {
     d->unique = unique;
+    d->connection.setAccepting(unique);
 }
 
 auto App::styleName() const -> QString
@@ -37,6 +37,8 @@ public:
     auto setUnique(bool unique) -> void;
     auto runCommands() -> void;
     auto isOpenGLDebugLoggerRequested() const -> bool;
+    // false if non-critical subsystems can wait for the first frame
+    auto isEagerInitRequested() const -> bool;
     auto setMprisActivated(bool activated) -> void;
     auto sendMessage(MessageType type, const QJsonValue &t, int timeout = 5000) -> bool;
     auto sendMessage(MessageType type, const QStringList &t, int timeout = 5000) -> bool;
@@ -48,6 +50,8 @@ public:
     static constexpr auto name() -> const char* { return "bomi"; }
     static auto displayName() -> QString { return tr("bomi"); }
     static auto defaultIcon() -> QIcon;
+    // send command line to running instance before App is created
+    static auto forwardCommandLine(int argc, char **argv) -> bool;
 private:
     auto handleMessage(const QByteArray &message) -> void;
     static constexpr int ReopenEvent = QEvent::User + 1;
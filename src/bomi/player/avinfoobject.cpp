@@ -46,6 +46,14 @@ auto AvTrackObject::fromTrack(int n, const StreamTrack &track) -> AvTrackObject*
     return info;
 }
 
+auto AvTrackObject::isSame(const StreamTrack &track) const -> bool
+{
+    return m_id == track.id() && m_type == track.type()
+           && m_albumart == track.isAlbumArt()
+           && m_codec == track.codec() && m_title == track.title()
+           && m_lang == track.language() && m_enc == track.encoding().name();
+}
+
 AvCommonObject::AvCommonObject(int type)
 {
     m_dummy.m_type = type;
@@ -63,22 +71,34 @@ auto AvCommonObject::track() const -> AvTrackObject*
     return &m_dummy;
 }
 
-auto AvCommonObject::update(const StreamList &tracks, bool clear) -> AvTrackObject*
+auto AvCommonObject::update(const StreamList &tracks1, const StreamList &tracks2) -> AvTrackObject*
 {
-    if (clear) {
-        for (auto track : m_tracks) {
-            QQmlEngine::setObjectOwnership(track, QQmlEngine::JavaScriptOwnership);
-        }
-//        qDeleteAll(m_tracks);
-        m_tracks.clear();
-    }
-    m_tracks.reserve(m_tracks.size() + tracks.size());
+    // matched by id, so insertion or removal doesn't recreate other tracks
+    QHash<QPair<int, int>, AvTrackObject*> old;
+    for (auto track : m_tracks)
+        old.insert(qMakePair(track->m_type, track->m_id), track);
+    m_tracks.clear();
+    m_tracks.reserve(tracks1.size() + tracks2.size());
     AvTrackObject *sel = nullptr;
-    for (auto track : tracks) {
-        m_tracks.push_back(AvTrackObject::fromTrack(m_tracks.size() + 1, track));
-        if (track.isSelected())
-            sel = m_tracks.back();
+    for (auto tracks : { &tracks1, &tracks2 }) {
+        for (auto &track : *tracks) {
+            const int n = m_tracks.size() + 1;
+            auto obj = old.take(qMakePair<int, int>(track.type(), track.id()));
+            if (obj && obj->isSame(track)) {
+                obj->setNumber(n);
+                obj->setSelected(track.isSelected());
+            } else {
+                if (obj)
+                    QQmlEngine::setObjectOwnership(obj, QQmlEngine::JavaScriptOwnership);
+                obj = AvTrackObject::fromTrack(n, track);
+            }
+            m_tracks.push_back(obj);
+            if (track.isSelected())
+                sel = obj;
+        }
     }
+    for (auto track : old)
+        QQmlEngine::setObjectOwnership(track, QQmlEngine::JavaScriptOwnership);
     return sel;
 }
 
@@ -213,10 +233,7 @@ SubtitleObject::SubtitleObject()
 
 auto SubtitleObject::setTracks(const StreamList &tracks1, const StreamList &tracks2) -> void
 {
-    auto sel = update(tracks1);
-    if (auto sel2 = update(tracks2, false))
-        sel = sel2;
-    setTrack(sel);
+    setTrack(update(tracks1, tracks2));
     m_selection.clear();
     for (auto track : trackObjects()) {
         if (track->isSelected())
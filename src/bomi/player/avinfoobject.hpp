@@ -3,6 +3,7 @@
 
 #include "enum/colorrange.hpp"
 #include "enum/colorspace.hpp"
+#include "video/frametiming.hpp"
 #include <QQmlListProperty>
 
 class AudioFormat;                      class StreamTrack;
@@ -56,11 +57,11 @@ private:
 
 class AvTrackObject : public QObject {
     Q_OBJECT
-    Q_PROPERTY(int number READ number CONSTANT FINAL)
+    Q_PROPERTY(int number READ number NOTIFY numberChanged)
     Q_PROPERTY(QString title READ title CONSTANT FINAL)
     Q_PROPERTY(QString language READ language CONSTANT FINAL)
     Q_PROPERTY(bool valid READ isValid CONSTANT FINAL)
-    Q_PROPERTY(bool selected READ isSelected CONSTANT FINAL)
+    Q_PROPERTY(bool selected READ isSelected NOTIFY selectedChanged)
     Q_PROPERTY(QString codec READ codec CONSTANT FINAL)
     Q_PROPERTY(QString encoding READ encoding CONSTANT FINAL)
     Q_PROPERTY(QString typeText READ typeText CONSTANT FINAL)
@@ -78,7 +79,16 @@ public:
     auto isAlbumArt() const -> bool { return m_albumart; }
     auto typeText() const -> QString;
     static auto fromTrack(int n, const StreamTrack &track) -> AvTrackObject*;
+signals:
+    void numberChanged();
+    void selectedChanged();
 private:
+    // compares all but number and selection, which are updated in place
+    auto isSame(const StreamTrack &track) const -> bool;
+    auto setNumber(int n) -> void
+        { if (_Change(m_number, n)) emit numberChanged(); }
+    auto setSelected(bool s) -> void
+        { if (_Change(m_selected, s)) emit selectedChanged(); }
     friend class AvCommonObject;
     int m_id = -1, m_number = -1, m_type = 0;
     QString m_title, m_lang, m_codec, m_enc, m_typeText;
@@ -103,7 +113,9 @@ signals:
     void trackChanged();
 protected:
     void setTrack(AvTrackObject *track) { m_track = track; }
-    auto update(const StreamList &tracks, bool clear = true) -> AvTrackObject*;
+    // returns last selection, reusing objects of tracks with same type and id
+    // unless their metadata have changed
+    auto update(const StreamList &tracks1, const StreamList &tracks2 = StreamList()) -> AvTrackObject*;
 private:
     auto setTracks(const StreamList &tracks) -> void;
     auto setTracks(const StreamList &tracks1, const StreamList &tracks2) -> void;
@@ -269,6 +281,7 @@ class VideoObject : public AvCommonObject {
     Q_PROPERTY(VideoToolObject *hardwareAcceleration READ hwacc CONSTANT FINAL)
     Q_PROPERTY(VideoToolObject *deinterlacer READ deint CONSTANT FINAL)
     Q_PROPERTY(VideoRenderer *screen READ screen CONSTANT FINAL)
+    Q_PROPERTY(FrameTimingObject *frameTiming READ frameTiming CONSTANT FINAL)
     Q_PROPERTY(int droppedFrames READ droppedFrames NOTIFY droppedFramesChanged)
     Q_PROPERTY(int delayedFrames READ delayedFrames NOTIFY delayedFramesChanged)
     Q_PROPERTY(qreal delayedTime READ delayedTime NOTIFY delayedTimeChanged)
@@ -304,6 +317,8 @@ public:
     auto frameCount() const -> qint64 { return m_frameCount; }
     auto screen() const -> VideoRenderer* { return m_screen; }
     auto setScreen(VideoRenderer *vr) { m_screen = vr; }
+    auto frameTiming() -> FrameTimingObject* { return &m_timing; }
+    auto frameTiming() const -> const FrameTimingObject* { return &m_timing; }
 signals:
     void frameCountChanged();
     void frameNumberChanged();
@@ -319,6 +334,7 @@ private:
     qint64 m_frameCount = 0, m_frameNumber = 0;
     QTime m_time;
     VideoRenderer *m_screen = nullptr;
+    FrameTimingObject m_timing;
 };
 
 /******************************************************************************/
@@ -189,7 +189,7 @@ HistoryModel::HistoryModel(QObject *parent)
             }
         }
     }
-    d->load();
+    // list is queried when the view is shown
 }
 
 HistoryModel::~HistoryModel() {
@@ -221,6 +221,13 @@ auto HistoryModel::getState(MrlState *state) const -> bool
     return true;
 }
 
+auto HistoryModel::restore(MrlState *state, const MrlState *fetched) const -> void
+{
+    QMutexLocker locker(&d->mutex);
+    for (auto &f : d->restores)
+        f.property().write(state, f.property().read(fetched));
+}
+
 auto HistoryModel::find(const Mrl &mrl) const -> const MrlState*
 {
     QMutexLocker locker(&d->mutex);
@@ -245,7 +252,7 @@ auto HistoryModel::play(int row) -> void
 auto HistoryModel::setShowMediaTitleInName(bool local, bool url) -> void
 {
     if (_Change(d->mediaTitleLocal, local) | _Change(d->mediaTitleUrl, url))
-        d->load();
+        update();
 }
 
 auto HistoryModel::getData(const int row, int role) const -> QVariant
@@ -335,7 +342,10 @@ auto HistoryModel::setStarred(int row, bool star) -> void
 
 auto HistoryModel::update() -> void
 {
-    d->load();
+    if (d->visible)
+        d->load();
+    else
+        d->reload = true;
 }
 
 auto HistoryModel::update(const MrlState *state, const QString &column, bool reload) -> void
@@ -412,7 +422,7 @@ auto HistoryModel::clear() -> void
     Transactor t(&d->db);
     d->loader.exec("DELETE FROM "_a % d->table % " WHERE star != 1 OR star IS NULL"_a);
     t.done();
-    d->load();
+    update();
 }
 
 auto HistoryModel::isVisible() const -> bool
@@ -422,6 +432,9 @@ auto HistoryModel::isVisible() const -> bool
 
 auto HistoryModel::setVisible(bool visible) -> void
 {
-    if (_Change(d->visible, visible))
-        emit visibleChanged(d->visible);
+    if (!_Change(d->visible, visible))
+        return;
+    if (d->visible && d->reload)
+        d->load();
+    emit visibleChanged(d->visible);
 }
@@ -20,6 +20,8 @@ public:
     auto roleNames() const -> QHash<int, QByteArray>;
     auto find(const Mrl &mrl) const -> const MrlState*;
     auto getState(MrlState *state) const -> bool;
+    // copy properties to restore from state got by getState() before
+    auto restore(MrlState *state, const MrlState *fetched) const -> void;
     auto update(const MrlState *state, const QString &column, bool reload) -> void;
     auto update(const MrlState *state, bool reload) -> void;
     auto setShowMediaTitleInName(bool local, bool url) -> void;
@@ -29,6 +31,7 @@ public:
     auto clear() -> void;
     auto isVisible() const -> bool;
     auto setVisible(bool visible) -> void;
+    // list is reloaded now if visible, otherwise when it's shown
     auto update() -> void;
     auto toggle() -> void { setVisible(!isVisible()); }
     Q_INVOKABLE bool isStarred(int row) const;
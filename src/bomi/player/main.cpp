@@ -2,6 +2,7 @@
 #include "dialog/mbox.hpp"
 #include "json/jrserver.hpp"
 #include "player/jrplayer.hpp"
+#include "misc/startupprofiler.hpp"
 #include <QCryptographicHash>
 #include <QElapsedTimer>
 #ifdef Q_OS_LINUX
@@ -25,10 +26,14 @@ SIA measure(F func, int loop = 100000) -> quint64
 }
 
 int main(int argc, char **argv) {
+    StartupProfiler::mark("main");
 #ifdef BOMI_IMPORT_ICU
     Locale::importIcu();
     return 0;
 #endif
+    // nothing to initialize if running instance takes the command line
+    if (App::forwardCommandLine(argc, argv))
+        return 0;
 #ifdef Q_OS_LINUX
     signal(SIGPIPE, SIG_IGN);
     auto gtk_disable_setlocale
@@ -44,8 +49,10 @@ int main(int argc, char **argv) {
     QApplication::setApplicationVersion(_L(cApp.version()));
 
     registerType();
+    StartupProfiler::mark("register-types");
 
     QScopedPointer<App> app(new App(argc, argv));
+    StartupProfiler::mark("create-app");
 
 #ifdef Q_OS_WIN
     const char sep = ';';
@@ -60,8 +67,10 @@ int main(int argc, char **argv) {
 
     if (app->executeToQuit())
         return 0;
+    StartupProfiler::mark("execute-command-line");
 
     const auto error = OGL::check();
+    StartupProfiler::mark("check-opengl");
     if (!error.isEmpty()) {
         MBox mbox(nullptr, MBox::Icon::Critical,
                   qApp->translate("OpenGL", "OpenGL Error"),
@@ -77,9 +86,11 @@ int main(int argc, char **argv) {
     qsrand(QDateTime::currentMSecsSinceEpoch());
 
     MainWindow *mw = new MainWindow;
+    StartupProfiler::mark("create-main-window");
     _Debug("Show MainWindow.");
     mw->show();
     app->setMainWindow(mw);
+    StartupProfiler::mark("show-main-window");
     _Debug("Start main event loop.");
 
     auto ret = app->exec();
@@ -70,6 +70,7 @@ auto registerType() -> void
     qmlRegisterType<MouseEventObject>();
     qmlRegisterType<VideoPreview>();
     qmlRegisterType<VideoRenderer>();
+    qmlRegisterType<FrameTimingObject>();
 
     qmlRegisterSingletonType<AppObject>("bomi", 1, 0, "App", _QmlSingleton<AppObject>);
     qmlRegisterSingletonType<FormatObject>("bomi", 1, 0, "Format", _QmlSingleton<FormatObject>);
@@ -4,6 +4,7 @@
 #include "dialog/mbox.hpp"
 #include "dialog/encoderdialog.hpp"
 #include "quick/appobject.hpp"
+#include "misc/startupprofiler.hpp"
 #include <QSessionManager>
 
 //DECLARE_LOG_CONTEXT(Main)
@@ -13,6 +14,7 @@ MainWindow::MainWindow()
     , m_engine(new PlayEngine), d(new Data(this))
 {
     d->p = this;
+    d->deferred.enabled = !cApp.isEagerInitRequested();
 
     cApp.setWindowTitle(this, QString());
     setColor(Qt::black);
@@ -28,6 +30,7 @@ MainWindow::MainWindow()
 
     d->pref.initialize();
     d->pref.load();
+    StartupProfiler::mark("load-preferences");
     d->undo.setActive(false);
     d->logViewer = d->dialog<LogViewer>();
     d->adapter = OS::adapter(this);
@@ -46,12 +49,14 @@ MainWindow::MainWindow()
     d->e.setYouTube(&d->youtube);
     d->e.setYle(&d->yle);
     d->e.run();
+    StartupProfiler::mark("run-engine");
 
     d->initContextMenu();
     d->initItems();
-    d->initTray();
+    d->defer("create-tray", [=] () { d->initTray(); });
     d->plugEngine();
     d->plugMenu();
+    StartupProfiler::mark("plug-menu");
 
     connect(this, &QQuickView::statusChanged, this, [=] (Status status)
         { if (status == Ready) d->top->setParentItem(contentItem()); });
@@ -63,6 +68,7 @@ MainWindow::MainWindow()
             m_glLogger->initialize(context);
         m_sgInit = true;
         m_engine->initializeGL(this, context);
+        StartupProfiler::mark("initialize-scene-graph");
         emit sceneGraphInitialized();
         _Debug("Scene graph initialized.");
     }, Qt::DirectConnection);
@@ -83,8 +89,18 @@ MainWindow::MainWindow()
 
     d->restoreState();
     d->undo.setActive(true);
+    StartupProfiler::mark("restore-state");
     QTimer::singleShot(1, this, SLOT(postInitialize()));
 
+    d->deferred.timeout.setSingleShot(true);
+    d->deferred.timeout.setInterval(5000);
+    connect(&d->deferred.timeout, &QTimer::timeout,
+            this, [=] () { d->runDeferred(); });
+    connect(&d->e, &PlayEngine::started,
+            this, [=] () { d->deferred.playback = false; });
+    connect(&d->e, &PlayEngine::stateChanged, this, [=] (PlayEngine::State state)
+        { if (state == PlayEngine::Error) d->deferred.playback = false; });
+
 #ifdef Q_OS_WIN
     d->taskbar.setWindow(this);
     d->taskbar.progress()->setVisible(true);
@@ -112,8 +128,18 @@ auto MainWindow::postInitialize() -> void
     d->as.restoreWindowGeometry(this);
     d->adapter->setImeEnabled(false);
     d->applyPref();
+    StartupProfiler::mark("apply-preferences");
     cApp.runCommands();
     d->noMessage = false;
+    StartupProfiler::mark("run-commands");
+
+    // media to open has been handed to engine already or will be opened
+    // right after scene graph initialized, that is, before any frame swapped
+    d->deferred.swapped = connect(this, &QQuickWindow::frameSwapped, this, [=] () {
+        if (!d->deferred.playback)
+            d->runDeferred();
+    }, Qt::QueuedConnection);
+    d->deferred.timeout.start();
 }
 
 auto MainWindow::adapter() const -> OS::WindowAdapter*
@@ -21,6 +21,7 @@
 #include "video/interpolatorparams.hpp"
 #include "audio/visualizer.hpp"
 #include "misc/filenamegenerator.hpp"
+#include "avinfoobject.hpp"
 #include <QThreadPool>
 #include <QClipboard>
 
@@ -457,6 +458,8 @@ auto MainWindow::Data::plugMenu() -> void
                                e.frameSize(), fileNameGenerator());
             encoder->setAudio(e.currentAudioStreamTrack());
             encoder->setSubtitle(e.currentSubtitleStreamTrack(), pref.sub_style());
+            encoder->setSubtitleComponents(e.subtitleSelection(),
+                                           e.video()->decoder()->fps());
             if (a >= 0)
                 encoder->setRange(a, b);
             encoder->show();
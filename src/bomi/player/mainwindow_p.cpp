@@ -19,6 +19,7 @@
 #include "avinfoobject.hpp"
 #include "misc/smbauth.hpp"
 #include "misc/filenamegenerator.hpp"
+#include "misc/startupprofiler.hpp"
 #include <QSessionManager>
 #include <QScreen>
 
@@ -187,6 +188,7 @@ auto MainWindow::Data::plugEngine() -> void
     });
     connect(&e, &PlayEngine::started, p, [=] (const Mrl &mrl) {
         setOpen(mrl);
+        e.prefetch(playlist.nextMrl(), true);
         if (encoder && !encoder->isBusy())
             encoder->hide();
     });
@@ -219,6 +221,8 @@ auto MainWindow::Data::initItems() -> void
             p, [this] (const Mrl &mrl) { openMrl(mrl); });
     connect(&playlist, &PlaylistModel::playRequested,
             p, [this] (int row) { openMrl(playlist.at(row)); });
+    connect(&playlist, &PlaylistModel::selectedChanged,
+            p, [this] () { e.prefetch(playlist.value(playlist.selected())); });
 
     hider.setSingleShot(true);
     connect(&hider, &QTimer::timeout, p, [this] () { setCursorVisible(false); });
@@ -609,18 +613,20 @@ auto MainWindow::Data::applyPref() -> void
                                pref.preserve_file_name_format(),
                                pref.preserve_fallback_folder());
     SubtitleParser::setMsPerCharactor(p.ms_per_char());
-    cApp.setMprisActivated(p.use_mpris2());
-
-    if (p.jr_use()) {
-        _Renew(jrServer, p.jr_connection(), p.jr_protocol());
-        jrServer->setInterface(&jrPlayer);
-        jrServer->setErrorHandler([=] (auto) {
-            MBox::error(nullptr, tr("JSON-RPC Server Error"),
-                        jrServer->errorString(), {BBox::Ok});
-        });
-        jrServer->listen(p.jr_address(), p.jr_port());
-    } else
-        _Delete(jrServer);
+    SubtitleRenderer::setPrerenderWindow(p.sub_prerender_window() * 1000);
+    defer("start-remote-control", [this] () {
+        cApp.setMprisActivated(pref.use_mpris2());
+        if (pref.jr_use()) {
+            _Renew(jrServer, pref.jr_connection(), pref.jr_protocol());
+            jrServer->setInterface(&jrPlayer);
+            jrServer->setErrorHandler([=] (auto) {
+                MBox::error(nullptr, tr("JSON-RPC Server Error"),
+                            jrServer->errorString(), {BBox::Ok});
+            });
+            jrServer->listen(pref.jr_address(), pref.jr_port());
+        } else
+            _Delete(jrServer);
+    });
 
     MouseBehavior context = MouseBehavior::NoBehavior;
     contextMenuModifier = KeyModifier::None;
@@ -770,12 +776,46 @@ auto MainWindow::Data::videoSize(const WindowSize &hint) -> QSize
 auto MainWindow::Data::load(const Mrl &mrl, bool play, bool tryResume,
                             const QString &sub) -> void
 {
-    if (play)
+    if (play) {
+        deferred.playback = !deferred.done;
         e.load(mrl, tryResume, sub);
-    else
+    } else
         e.setMrl(mrl);
 }
 
+auto MainWindow::Data::defer(const char *name, std::function<void(void)> &&task) -> void
+{
+    if (!deferred.enabled || deferred.done) {
+        task();
+        return;
+    }
+    for (auto &t : deferred.tasks) {
+        if (!qstrcmp(t.first, name)) {
+            t.second = std::move(task);
+            return;
+        }
+    }
+    deferred.tasks.push_back(qMakePair(name, std::move(task)));
+}
+
+auto MainWindow::Data::runDeferred() -> void
+{
+    // queued swaps can be delivered after disconnected
+    if (deferred.done)
+        return;
+    deferred.done = true;
+    deferred.timeout.stop();
+    QObject::disconnect(deferred.swapped);
+    StartupProfiler::mark(deferred.playback ? "timeout-for-first-frame" : "first-frame");
+    deferred.playback = false;
+    for (auto &task : deferred.tasks) {
+        task.second();
+        StartupProfiler::mark(task.first);
+    }
+    deferred.tasks.clear();
+    StartupProfiler::finish("finish-startup");
+}
+
 auto MainWindow::Data::clear() -> void
 {
     this->player = nullptr;
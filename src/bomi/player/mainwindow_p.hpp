@@ -134,6 +134,16 @@ struct MainWindow::Data {
     Qt::WindowState prevWindowState = Qt::WindowNoState;
     int wheelAngles = 0;
 
+    // non-critical initialization waiting for the first frame of media
+    struct {
+        bool enabled = false, done = false, playback = false;
+        QTimer timeout;
+        QMetaObject::Connection swapped;
+        QList<QPair<const char*, std::function<void(void)>>> tasks;
+    } deferred;
+    auto defer(const char *name, std::function<void(void)> &&task) -> void;
+    auto runDeferred() -> void;
+
     auto fileNameGenerator(const QTime &end = QTime()) const -> FileNameGenerator;
 
     template<class T, class... Args>
@@ -2,15 +2,10 @@
 #include "video/mpvosdrenderer.hpp"
 #include <QOpenGLContext>
 #include <QLibrary>
-
-struct PropertyObservation {
-    int event;
-    const char *name = nullptr;
-    std::function<void(int)> notify = nullptr;      // post from mpv to qt
-    std::function<void(QEvent*)> process = nullptr; // handle posted event
-};
+#include <QElapsedTimer>
 
 static constexpr const int UpdateEventBegin = QEvent::User + 10000;
+static constexpr const int FlushEvent = UpdateEventBegin - 1;
 
 auto Mpv::e2l(int error) -> Log::Level
 {
@@ -28,22 +23,102 @@ auto Mpv::e2l(int error) -> Log::Level
 }
 
 struct Mpv::Data {
+    struct PropertyObservation {
+        int event;
+        const char *name = nullptr;
+        mpv_format format = MPV_FORMAT_NONE;
+        // called in mpv thread, property carries value unless format is none
+        Notify notify = nullptr;
+    };
     Mpv *p = nullptr;
     mpv_opengl_cb_context *gl = nullptr;
     MpvOsdRenderer osd;
+    OpenGLBenchmarker::Scope scope = OpenGLBenchmarker::Video;
     bool quit = false;
+    // set by wakeup callback of mpv, cleared by playloop thread
+    QMutex wakeMutex;
+    QWaitCondition wake;
+    bool woken = false;
+    // in us; first wakeup since last drain, guarded by wakeMutex, and its
+    // copy for events being drained by playloop thread
+    QElapsedTimer clock;
+    qint64 wokenAt = 0, drainWokenAt = 0;
+    std::atomic<quint64> wakeupCount{0}, eventCount{0};
     QVector<PropertyObservation> observations;
     QVector<std::function<void(mpv_event*)>> events;
     QMap<QByteArray, std::function<void(void)>> hooks;
     int updateEventMax = ::UpdateEventBegin;
     int hookId = 0;
     std::function<void(void)> update;
+    // last delivery of each observation and order of changes, guarded by flushMutex
+    mutable QMutex flushMutex;
+    QVector<Mpv::Delivery> pending;
+    QVector<int> dirty;
+    QVector<Mpv::DeliveryStats> stats;
+    bool flushPosted = false;
+    quint64 flushCount = 0;
+    mutable QMutex latencyMutex;
+    QMap<QByteArray, Mpv::LatencyStats> latency;
+    auto now() const -> qint64 { return clock.nsecsElapsed() / 1000; }
+    auto record(const QByteArray &name, bool hook,
+                qint64 wait, qint64 execution, qint64 total) -> void
+    {
+        QMutexLocker locker(&latencyMutex);
+        auto &stats = latency[name];
+        stats.name = name;
+        stats.hook = hook;
+        stats.wait.add(wait);
+        stats.execution.add(execution);
+        stats.total.add(total);
+    }
+    auto reply(mpv_event *ev, const char *what) -> void
+    {
+        QScopedPointer<Request> request(reinterpret_cast<Request*>(ev->reply_userdata));
+        if (!isSuccess(ev->error)) {
+            _Debug("Error %%: Couldn't %% %%.",
+                   mpv_error_string(ev->error), what, request->name);
+        }
+        // request issued after wakeup has waited only since it was issued
+        const auto at = now(), total = at - request->issued;
+        const auto wait = qBound(0ll, at - drainWokenAt, total);
+        record(request->name, false, wait, total - wait, total);
+    }
     auto observation(int event) -> const PropertyObservation&
     {
         Q_ASSERT(UpdateEventBegin <= event && event < updateEventMax);
         Q_ASSERT(event == observations[event - UpdateEventBegin].event);
         return observations[event - UpdateEventBegin];
     }
+    // returns true if observer has to be asked to flush
+    auto queue(int event, Mpv::Delivery &&delivery) -> bool
+    {
+        const int i = event - UpdateEventBegin;
+        QMutexLocker locker(&flushMutex);
+        if (!pending[i])
+            dirty.push_back(i);
+        pending[i] = std::move(delivery);
+        ++stats[i].changes;
+        return _Change(flushPosted, true);
+    }
+    auto flush() -> void
+    {
+        QVector<Mpv::Delivery> deliveries;
+        {
+            QMutexLocker locker(&flushMutex);
+            deliveries.reserve(dirty.size());
+            for (int i : dirty) {
+                deliveries.push_back(std::move(pending[i]));
+                pending[i] = nullptr;
+                ++stats[i].deliveries;
+            }
+            dirty.clear();
+            flushPosted = false;
+            ++flushCount;
+        }
+        // deliveries may call mpv, so never hold the lock here
+        for (auto &deliver : deliveries)
+            deliver();
+    }
     auto reset()
     {
         quit = false;
@@ -52,6 +127,15 @@ struct Mpv::Data {
         hooks.clear();
         updateEventMax = ::UpdateEventBegin;
         hookId = 0;
+        wakeupCount = eventCount = 0;
+        QMutexLocker locker(&flushMutex);
+        pending.clear();
+        dirty.clear();
+        stats.clear();
+        flushPosted = false;
+        flushCount = 0;
+        QMutexLocker latencyLocker(&latencyMutex);
+        latency.clear();
     }
 };
 
@@ -59,6 +143,7 @@ Mpv::Mpv(QObject *parent)
     : QThread(parent), d(new Data)
 {
     d->p = this;
+    d->clock.start();
 }
 
 Mpv::~Mpv()
@@ -124,11 +209,19 @@ auto Mpv::setUpdateCallback(std::function<void ()> &&cb) -> void
     mpv_opengl_cb_set_update_callback(d->gl, update, d);
 }
 
+auto Mpv::setBenchmarkScope(OpenGLBenchmarker::Scope scope) -> void
+{
+    d->scope = scope;
+}
+
 auto Mpv::render(OpenGLFramebufferObject *frame, OpenGLFramebufferObject *osd, const QMargins &m) -> int
 {
     int ret = 0;
     if (frame) {
+        auto &bm = OpenGLBenchmarker::instance();
+        bm.begin(d->scope);
         ret = mpv_opengl_cb_draw(d->gl, frame->id(), frame->width(), frame->height());
+        bm.end(d->scope);
     }
     if (osd) {
         d->osd.prepare(osd);
@@ -176,6 +269,11 @@ auto Mpv::hook(const QByteArray &when, std::function<void ()> &&run) -> void
     d->hooks[when] = std::move(run);
 }
 
+auto Mpv::newRequest(QByteArray &&name) -> Request*
+{
+    return new Request{std::move(name), d->now()};
+}
+
 auto Mpv::request(mpv_event_id id, std::function<void(mpv_event*)> &&proc) -> void
 {
     if (d->events.size() < id + 1)
@@ -184,18 +282,22 @@ auto Mpv::request(mpv_event_id id, std::function<void(mpv_event*)> &&proc) -> vo
     d->events[id] = std::move(proc);
 }
 
-auto Mpv::newObservation(const char *name, std::function<void(int)> &&notify,
-                  std::function<void(QEvent*)> &&process) -> int
+auto Mpv::newObservation(const char *name, mpv_format format, Notify &&notify) -> int
 {
     const int event = d->updateEventMax++;
-    PropertyObservation ob;
+    Data::PropertyObservation ob;
     ob.event = event;
     ob.name = name;
+    ob.format = format;
     ob.notify = std::move(notify);
-    ob.process = std::move(process);
     d->observations.append(ob);
+    {
+        QMutexLocker locker(&d->flushMutex);
+        d->pending.append(nullptr);
+        d->stats.append({ name, 0, 0 });
+    }
     Q_ASSERT(d->observations.size() == d->updateEventMax - UpdateEventBegin);
-    mpv_observe_property(m_handle, ob.event, ob.name, MPV_FORMAT_NONE);
+    mpv_observe_property(m_handle, ob.event, ob.name, ob.format);
     return event;
 }
 
@@ -211,84 +313,183 @@ auto Mpv::get_osd(const char *name) const -> QString
     auto ret = QString::fromLatin1(buf); mpv_free(buf); return ret;
 }
 
+auto Mpv::wakeups() const -> quint64
+{
+    return d->wakeupCount;
+}
+
+auto Mpv::events() const -> quint64
+{
+    return d->eventCount;
+}
+
+auto Mpv::deliveryStats() const -> QVector<DeliveryStats>
+{
+    QMutexLocker locker(&d->flushMutex);
+    return d->stats;
+}
+
+auto Mpv::flushes() const -> quint64
+{
+    QMutexLocker locker(&d->flushMutex);
+    return d->flushCount;
+}
+
 auto Mpv::run() -> void
 {
     _Debug("Start playloop thread");
     d->quit = false;
+    d->woken = true;
+    mpv_set_wakeup_callback(m_handle, [] (void *p) {
+        auto d = static_cast<Data*>(p);
+        QMutexLocker locker(&d->wakeMutex);
+        if (!d->woken)
+            d->wokenAt = d->now();
+        d->woken = true;
+        d->wake.wakeAll();
+    }, d);
     while (!d->quit) {
-        auto ev = mpv_wait_event(m_handle, 0.005);
-        switch (ev->event_id) {
-        case MPV_EVENT_NONE:
-            break;
-        case MPV_EVENT_PROPERTY_CHANGE: {
-            auto &o = d->observation(ev->reply_userdata);
-            o.notify(o.event);
-            break;
-        } case MPV_EVENT_LOG_MESSAGE: {
-            auto msg = static_cast<mpv_event_log_message*>(ev->data);
-            if (msg->log_level == MPV_LOG_LEVEL_NONE)
+        d->wakeMutex.lock();
+        while (!d->woken)
+            d->wake.wait(&d->wakeMutex);
+        d->woken = false;
+        d->drainWokenAt = d->wokenAt;
+        d->wakeMutex.unlock();
+        ++d->wakeupCount;
+        // drain all events which have arrived until now
+        while (!d->quit) {
+            auto ev = mpv_wait_event(m_handle, 0);
+            if (ev->event_id == MPV_EVENT_NONE)
                 break;
-            auto getLevel = [&]() {
-                switch (msg->log_level) {
-                case MPV_LOG_LEVEL_TRACE: return Log::Trace;
-                case MPV_LOG_LEVEL_V:
-                case MPV_LOG_LEVEL_DEBUG: return Log::Debug;
-                case MPV_LOG_LEVEL_INFO:  return Log::Info;
-                case MPV_LOG_LEVEL_WARN:  return Log::Warn;
-                default:                  return Log::Error;
-                }
-            };
-            const auto lv = getLevel();
-            Log::print(lv, Log::parse(lv, m_logContext + '/' + msg->prefix, msg->text));
-            break;
-        } case MPV_EVENT_CLIENT_MESSAGE: {
-            auto message = static_cast<mpv_event_client_message*>(ev->data);
-            if (message->num_args < 1)
-                break;
-            if (!qstrcmp(message->args[0], "hook_run") && message->num_args == 3) {
-                QByteArray when(message->args[2]);
-                Q_ASSERT(d->hooks.contains(when));
-                d->hooks[when]();
-                tell("hook_ack", when);
-            }
-            break;
-        } case MPV_EVENT_SET_PROPERTY_REPLY: {
-            QScopedPointer<QByteArray> name(reinterpret_cast<QByteArray*>(ev->reply_userdata));
-            if (!isSuccess(ev->error)) {
-                _Debug("Error %%: Couldn't set property %%.",
-                       mpv_error_string(ev->error), *name);
-            }
+            ++d->eventCount;
+            processEvent(ev);
+        }
+    }
+    mpv_set_wakeup_callback(m_handle, nullptr, nullptr);
+    const quint64 wakeups = d->wakeupCount, events = d->eventCount;
+    _Debug("Finish playloop thread: %% events in %% wakeups (%% per wakeup)",
+           events, wakeups, wakeups ? events / double(wakeups) : 0.0);
+    quint64 changes = 0;
+    for (auto &s : deliveryStats())
+        changes += s.changes;
+    _Debug("%% property changes delivered in %% flushes", changes, flushes());
+    for (auto &s : latencyStats()) {
+        if (s.hook)
+            _Debug("Hook %%: %% runs, average %%us, p95 %%us, max %%us", s.name,
+                   s.total.count, s.total.average(), s.total.percentile(0.95), s.total.max);
+    }
+}
+
+auto Mpv::processEvent(mpv_event *ev) -> void
+{
+    switch (ev->event_id) {
+    case MPV_EVENT_PROPERTY_CHANGE: {
+        // data of typed property is valid only until next mpv_wait_event()
+        auto &o = d->observation(ev->reply_userdata);
+        auto delivery = o.notify(static_cast<mpv_event_property*>(ev->data));
+        if (delivery && d->queue(o.event, std::move(delivery)))
+            _PostEvent(m_observer, FlushEvent);
+        break;
+    } case MPV_EVENT_LOG_MESSAGE: {
+        auto msg = static_cast<mpv_event_log_message*>(ev->data);
+        if (msg->log_level == MPV_LOG_LEVEL_NONE)
             break;
-        } case MPV_EVENT_COMMAND_REPLY: {
-            QScopedPointer<QByteArray> name(reinterpret_cast<QByteArray*>(ev->reply_userdata));
-            if (!isSuccess(ev->error)) {
-                _Debug("Error %%: Couldn't execute command %%.",
-                       mpv_error_string(ev->error), *name);
+        auto getLevel = [&]() {
+            switch (msg->log_level) {
+            case MPV_LOG_LEVEL_TRACE: return Log::Trace;
+            case MPV_LOG_LEVEL_V:
+            case MPV_LOG_LEVEL_DEBUG: return Log::Debug;
+            case MPV_LOG_LEVEL_INFO:  return Log::Info;
+            case MPV_LOG_LEVEL_WARN:  return Log::Warn;
+            default:                  return Log::Error;
             }
+        };
+        const auto lv = getLevel();
+        Log::print(lv, Log::parse(lv, m_logContext + '/' + msg->prefix, msg->text));
+        break;
+    } case MPV_EVENT_CLIENT_MESSAGE: {
+        auto message = static_cast<mpv_event_client_message*>(ev->data);
+        if (message->num_args < 1)
             break;
-        } case MPV_EVENT_GET_PROPERTY_REPLY: {
-            auto event = static_cast<mpv_event_property*>(ev->data);
-            _Error("Never requested reply: %%", event->name);
-            break;
-        } case MPV_EVENT_SHUTDOWN:
-            d->quit = true;
+        if (!qstrcmp(message->args[0], "hook_run") && message->num_args == 3) {
+            QByteArray when(message->args[2]);
+            Q_ASSERT(d->hooks.contains(when));
+            const auto dispatched = d->now();
+            d->hooks[when]();
+            const auto executed = d->now();
+            tell("hook_ack", when);
+            // mpv is blocked until ack, so it is included in total
+            d->record(when, true, dispatched - d->drainWokenAt,
+                      executed - dispatched, d->now() - d->drainWokenAt);
+        }
+        break;
+    } case MPV_EVENT_SET_PROPERTY_REPLY: {
+        d->reply(ev, "set property");
+        break;
+    } case MPV_EVENT_COMMAND_REPLY: {
+        d->reply(ev, "execute command");
+        break;
+    } case MPV_EVENT_GET_PROPERTY_REPLY: {
+        auto event = static_cast<mpv_event_property*>(ev->data);
+        _Error("Never requested reply: %%", event->name);
+        break;
+    } case MPV_EVENT_SHUTDOWN:
+        d->quit = true;
+        break;
+    default: {
+        if (ev->event_id >= d->events.size())
             break;
-        default: {
-            if (ev->event_id >= d->events.size())
-                break;
-            if (auto &proc = d->events[ev->event_id])
-                proc(ev);
-        }}
-    }
-    _Debug("Finish playloop thread");
+        if (auto &proc = d->events[ev->event_id])
+            proc(ev);
+    }}
 }
 
 auto Mpv::process(QEvent *event) -> bool
 {
-    const int type = event->type();
-    if (UpdateEventBegin <= type && type < d->updateEventMax) {
-        d->observation(type).process(event);
-        return true;
+    if (event->type() != FlushEvent)
+        return false;
+    d->flush();
+    return true;
+}
+
+auto Mpv::Latency::add(qint64 us) -> void
+{
+    us = qMax(0ll, us);
+    int bin = 0;
+    for (auto v = us >> 1; v && bin < Bins - 1; v >>= 1)
+        ++bin;
+    ++bins[bin];
+    ++count;
+    total += us;
+    max = qMax(max, us);
+}
+
+auto Mpv::Latency::percentile(double p) const -> qint64
+{
+    if (!count)
+        return -1;
+    const auto target = qMax<quint64>(1, qCeil(count * qBound(0.0, p, 1.0)));
+    quint64 acc = 0;
+    for (int i = 0; i < Bins; ++i) {
+        acc += bins[i];
+        if (acc >= target)
+            return qMin(max, 1ll << (i + 1));
     }
-    return false;
+    return max;
+}
+
+auto Mpv::latencyStats() const -> QVector<LatencyStats>
+{
+    QMutexLocker locker(&d->latencyMutex);
+    QVector<LatencyStats> stats;
+    stats.reserve(d->latency.size());
+    for (auto &s : d->latency)
+        stats.push_back(s);
+    return stats;
+}
+
+auto Mpv::resetLatencyStats() -> void
+{
+    QMutexLocker locker(&d->latencyMutex);
+    d->latency.clear();
 }
@@ -5,6 +5,7 @@
 #include "tmp/type_traits.hpp"
 #include "misc/log.hpp"
 #include "misc/dataevent.hpp"
+#include "opengl/openglbenchmarker.hpp"
 #include <libmpv/client.h>
 #include <libmpv/opengl_cb.h>
 #include <functional>
@@ -57,9 +58,10 @@ public:
     template<class T>
     auto setAsync(QByteArray &&name, const T &value) -> bool
         { return _setAsync(std::move(name), pass(value)); }
+    // N counts terminating null of literal, which stays after raw data
     template<class T, int N>
     auto setAsync(const char (&name)[N], const T &value) -> bool
-        { return setAsync<T>(QByteArray::fromRawData(name, N), value); }
+        { return setAsync<T>(QByteArray::fromRawData(name, N - 1), value); }
 
     template<class... Args>
     auto tell(QByteArray &&name, const Args&... args) -> bool;
@@ -82,6 +84,12 @@ public:
     auto observe(const char *name, Set set) -> int;
     template<class Check>
     auto observeState(const char *name, Check ck) -> int;
+    // value of T comes with change event and map() converts it to be delivered
+    template<class T, class Map, class Set>
+    auto observeValue(const char *name, Map map, Set set) -> int;
+    // map() reads mpv_node of change event directly, which is empty if unavailable
+    template<class Map, class Set>
+    auto observeNode(const char *name, Map map, Set set) -> int;
     auto hook(const QByteArray &name, std::function<void(void)> &&run) -> void;
     auto request(mpv_event_id id, std::function<void(mpv_event*)> &&proc) -> void;
     template<class Proc>
@@ -91,10 +99,43 @@ public:
     auto update() -> void;
     auto render(OpenGLFramebufferObject *frame, OpenGLFramebufferObject *osd,
                 const QMargins &m) -> int;
+    // scope where drawing frame by render() is benchmarked
+    auto setBenchmarkScope(OpenGLBenchmarker::Scope scope) -> void;
     auto initializeGL(QOpenGLContext *ctx) -> void;
     auto finalizeGL() -> void;
     auto frameSwapped() -> void;
+    // playloop sleeps until mpv wakes it up and then handles all events
+    auto wakeups() const -> quint64;
+    auto events() const -> quint64;
+    // changes of a property are merged until observer flushes them at once
+    struct DeliveryStats { QByteArray name; quint64 changes = 0, deliveries = 0; };
+    auto deliveryStats() const -> QVector<DeliveryStats>;
+    auto flushes() const -> quint64;
+    // histogram of latencies in us where bin i counts [2^i, 2^(i+1)) and
+    // the first bin also counts 0
+    struct Latency {
+        static constexpr int Bins = 24;
+        quint64 count = 0;
+        qint64 total = 0, max = 0;
+        std::array<quint32, Bins> bins{{}};
+        auto add(qint64 us) -> void;
+        auto average() const -> qint64 { return count ? total / count : 0; }
+        // upper bound of the bin where p of latencies fall below
+        auto percentile(double p) const -> qint64;
+    };
+    // latencies of hook or async set/command, measured in playloop:
+    // wait from wakeup to handling, execution of hook function in bomi or
+    // of request in mpv, and total until hook is acked or reply is handled
+    struct LatencyStats {
+        QByteArray name; bool hook = false;
+        Latency wait, execution, total;
+    };
+    auto latencyStats() const -> QVector<LatencyStats>;
+    auto resetLatencyStats() -> void;
 private:
+    // user data of async request
+    struct Request { QByteArray name; qint64 issued; };
+    auto newRequest(QByteArray &&name) -> Request*;
     static auto e2s(int error) -> const char* { return mpv_error_string(error); }
     static auto e2l(int error) -> Log::Level;
     template <class T>
@@ -102,6 +143,7 @@ private:
     template<class T>
     auto _setAsync(QByteArray &&name, const T &value) -> bool;
     auto run() -> void override;
+    auto processEvent(mpv_event *ev) -> void;
     auto fill(mpv_node *) { }
     template<class T, class... Args>
     auto fill(mpv_node *it, const T &t, const Args&... args)
@@ -123,8 +165,12 @@ private:
         int error = f(&node);
         return MPV_CHECK(error, "execute %%", name);
     }
-    auto newObservation(const char *name, std::function<void(int)> &&notify,
-                        std::function<void(QEvent*)> &&process) -> int;
+    template<class T>
+    static auto eventValue(const mpv_event_property *p) -> T;
+    // returns delivery of changed value in observer's thread, if any
+    using Delivery = std::function<void(void)>;
+    using Notify = std::function<Delivery(const mpv_event_property*)>;
+    auto newObservation(const char *name, mpv_format format, Notify &&notify) -> int;
     struct Data; Data *d;
     mpv_handle *m_handle = nullptr;
     QObject *m_observer = nullptr;
@@ -156,11 +202,11 @@ auto Mpv::_setAsync(QByteArray &&name, const T &value) -> bool
 {
     static_assert(!is_string<T>(), "!!!");
     Q_ASSERT(m_handle);
-    auto user = new QByteArray(std::move(name));
+    auto user = newRequest(std::move(name));
     MpvSetScopedData<T> data(value);
     int error = mpv_set_property_async(m_handle, (quint64)user,
-                                       *user, data.format(), data.raw());
-    return MPV_CHECK(error, "set_async %%", name);
+                                       user->name, data.format(), data.raw());
+    return MPV_CHECK(error, "set_async %%", user->name);
 }
 
 template <class T>
@@ -183,54 +229,86 @@ auto Mpv::tell(QByteArray &&name, const Args&... args) -> bool
 
 template<int N, class... Args>
 auto Mpv::tell(const char (&name)[N], const Args&... args) -> bool
-    { return tell(QByteArray::fromRawData(name, N), args...); }
+    { return tell(QByteArray::fromRawData(name, N - 1), args...); }
 
 template<class... Args>
 auto Mpv::tellAsync(QByteArray &&name, const Args&... args) -> bool
 {
     return command(std::move(name), [&] (auto *node) {
-        auto user = new QByteArray(std::move(name));
+        auto user = newRequest(std::move(name));
         return mpv_command_node_async(m_handle, (quint64)user, node);
     }, pass(args)...);
 }
 
 template<int N, class... Args>
 auto Mpv::tellAsync(const char (&name)[N], const Args&... args) -> bool
-    { return tellAsync(QByteArray::fromRawData(name, N), args...); }
+    { return tellAsync(QByteArray::fromRawData(name, N - 1), args...); }
+
+template<class T>
+auto Mpv::eventValue(const mpv_event_property *p) -> T
+{
+    // format is MPV_FORMAT_NONE if property is unavailable
+    T t = T();
+    if (p && p->data && p->format == mpv_trait<T>::format)
+        mpv_trait<T>::get(t, *static_cast<const mpv_t<T>*>(p->data));
+    return t;
+}
 
 template<class Get, class Set>
 auto Mpv::observe(const char *name, Get get, Set set) -> tmp::enable_if_callable_t<Get, int>
 {
-    using T = tmp::remove_cref_t<decltype(get())>;
-    return newObservation(name, [=] (int e) { _PostEvent(m_observer, e, get()); },
-                          [=] (QEvent *event) { set(_MoveData<T>(event)); });
+    return newObservation(name, MPV_FORMAT_NONE, [=] (const mpv_event_property*) -> Delivery {
+        auto v = get();
+        return [=] () mutable { set(std::move(v)); };
+    });
+}
+
+template<class T, class Map, class Set>
+auto Mpv::observeValue(const char *name, Map map, Set set) -> int
+{
+    return newObservation(name, mpv_trait<T>::format, [=] (const mpv_event_property *p) -> Delivery {
+        auto v = map(eventValue<T>(p));
+        return [=] () mutable { set(std::move(v)); };
+    });
+}
+
+template<class Map, class Set>
+auto Mpv::observeNode(const char *name, Map map, Set set) -> int
+{
+    return newObservation(name, MPV_FORMAT_NODE, [=] (const mpv_event_property *p) -> Delivery {
+        mpv_node none; none.format = MPV_FORMAT_NONE;
+        const bool has = p && p->data && p->format == MPV_FORMAT_NODE;
+        auto v = map(has ? *static_cast<const mpv_node*>(p->data) : none);
+        return [=] () mutable { set(std::move(v)); };
+    });
 }
 
 template<class T, class Update>
 auto Mpv::observe(const char *name, T &t, Update update) -> tmp::enable_unless_callable_t<T, int>
 {
-    return observe(name, [=] () { return get<T>(name); },
-                   [=, &t] (T &&v) { if (_Change(t, v)) update(); });
+    return observeValue<T>(name, [] (T &&v) { return std::move(v); },
+                           [=, &t] (T &&v) { if (_Change(t, v)) update(); });
 }
 
 template<class Update>
 auto Mpv::observeTime(const char *name, int &t, Update update) -> int
 {
-    return observe(name, [=] () { return s2ms(get<double>(name)); },
-                   [=, &t] (int &&v) { if (_Change(t, v)) update(); });
+    return observeValue<double>(name, [] (double v) { return s2ms(v); },
+                                [=, &t] (int &&v) { if (_Change(t, v)) update(); });
 }
 
 template<class Set>
 auto Mpv::observe(const char *name, Set set) -> int {
     using T = tmp::remove_ref_t<tmp::func_arg_t<Set, 0>>;
-    return observe(name, [=] () { return get<T>(name); }, set);
+    return observeValue<T>(name, [] (T &&v) { return std::move(v); }, set);
 }
 
 template<class Check>
 auto Mpv::observeState(const char *name, Check ck) -> int
 {
     using T = tmp::remove_ref_t<tmp::func_arg_t<Check, 0>>;
-    return newObservation(name, [=] (int) { ck(get<T>(name)); }, [](QEvent*){});
+    return newObservation(name, mpv_trait<T>::format, [=] (const mpv_event_property *p) -> Delivery
+                          { ck(eventValue<T>(p)); return nullptr; });
 }
 
 #endif // MPV_HPP
@@ -269,6 +269,33 @@ struct mpv_trait<QVariant> {
     }
 };
 
+// f(key, value) for each entry of array or map node, key is null for array
+template<class F>
+SIA _ForEachMpvNode(const mpv_node &node, F f) -> void
+{
+    if (node.format != MPV_FORMAT_NODE_ARRAY && node.format != MPV_FORMAT_NODE_MAP)
+        return;
+    const auto list = node.u.list;
+    const bool map = node.format == MPV_FORMAT_NODE_MAP;
+    for (int i = 0; i < list->num; ++i)
+        f(map ? list->keys[i] : nullptr, list->values[i]);
+}
+
+SIA _MpvString(const mpv_node &node) -> QString
+{ return node.format == MPV_FORMAT_STRING ? QString::fromUtf8(node.u.string) : QString(); }
+
+SIA _MpvFlag(const mpv_node &node) -> bool
+{ return node.format == MPV_FORMAT_FLAG && node.u.flag; }
+
+SIA _MpvNumber(const mpv_node &node, double def = 0.0) -> double
+{
+    switch (node.format) {
+    case MPV_FORMAT_DOUBLE: return node.u.double_;
+    case MPV_FORMAT_INT64:  return node.u.int64;
+    default:                return def;
+    }
+}
+
 SIA operator<<(QDebug dbg, const mpv_node &node) -> QDebug
 {
     dbg.nospace() << "mpv_node->" << mpv_trait<QVariant>::parse(node);;
@@ -0,0 +1,139 @@
+#include "mrlprefetcher.hpp"
+#include "mrlstate.hpp"
+#include <QThreadPool>
+#include <QRunnable>
+
+static constexpr const int MaxEntries = 4;
+
+struct MrlPrefetcher::Entry {
+    Mrl mrl, key;
+    bool ahead = false, prepare = false;
+    bool started = false;   // guarded by Data::mutex
+    bool done = false;      // guarded by Data::mutex
+    bool dropped = false;   // guarded by Data::mutex, set unless taken
+    Result result;          // guarded by Data::mutex
+};
+
+struct MrlPrefetcher::Data {
+    QThreadPool pool, aheadPool;
+    Lookup lookup;
+    QMutex mutex;
+    QWaitCondition finished;
+    QList<EntryPtr> entries; // oldest first, guarded by mutex
+    // queued job of dropped entry returns without lookup
+    auto drop(const EntryPtr &entry) -> void { entry->dropped = true; }
+    auto find(const Mrl &key) const -> int
+    {
+        for (int i = 0; i < entries.size(); ++i) {
+            if (entries[i]->key == key)
+                return i;
+        }
+        return -1;
+    }
+};
+
+class MrlPrefetcher::Job : public QRunnable {
+public:
+    Job(Data *d, const EntryPtr &entry): d(d), m_entry(entry) { }
+private:
+    auto run() -> void final
+    {
+        {
+            QMutexLocker locker(&d->mutex);
+            if (m_entry->dropped)
+                return;
+            m_entry->started = true;
+        }
+        auto result = d->lookup(m_entry->mrl, m_entry->prepare);
+        QMutexLocker locker(&d->mutex);
+        m_entry->result = std::move(result);
+        m_entry->done = true;
+        d->finished.wakeAll();
+    }
+    Data *d = nullptr;
+    EntryPtr m_entry;
+};
+
+MrlPrefetcher::MrlPrefetcher()
+    : d(new Data)
+{
+    // lookups ahead have own thread so that slow ones never delay current one
+    for (auto pool : { &d->pool, &d->aheadPool }) {
+        pool->setMaxThreadCount(1);
+        pool->setExpiryTimeout(10000);
+    }
+}
+
+MrlPrefetcher::~MrlPrefetcher()
+{
+    clear();
+    for (auto pool : { &d->pool, &d->aheadPool }) {
+        pool->clear();
+        pool->waitForDone();
+    }
+    delete d;
+}
+
+auto MrlPrefetcher::setLookup(Lookup &&lookup) -> void
+{
+    d->lookup = std::move(lookup);
+}
+
+auto MrlPrefetcher::prefetch(const Mrl &mrl, bool ahead, bool prepare) -> void
+{
+    if (mrl.isEmpty() || !d->lookup)
+        return;
+    EntryPtr entry(new Entry);
+    entry->mrl = mrl;
+    entry->ahead = ahead;
+    entry->prepare = prepare;
+    entry->key = mrl.toUnique();
+    if (entry->key.isEmpty()) // disc without hash yet
+        return;
+    QMutexLocker locker(&d->mutex);
+    const int idx = d->find(entry->key);
+    if (idx >= 0) {
+        // selected row may become next one to be prepared
+        if (!prepare || d->entries[idx]->prepare)
+            return;
+        d->drop(d->entries.takeAt(idx));
+    }
+    d->entries.push_back(entry);
+    // a job in progress keeps its entry alive until it finishes
+    while (d->entries.size() > MaxEntries)
+        d->drop(d->entries.takeFirst());
+    (ahead ? d->aheadPool : d->pool).start(new Job(d, entry));
+}
+
+auto MrlPrefetcher::take(const Mrl &mrl) -> Result
+{
+    QMutexLocker locker(&d->mutex);
+    const int idx = d->find(mrl.toUnique());
+    if (idx < 0)
+        return Result();
+    const auto entry = d->entries.takeAt(idx);
+    // caller looks up by itself rather than waiting behind other jobs ahead
+    if (entry->ahead && !entry->started) {
+        d->drop(entry);
+        return Result();
+    }
+    while (!entry->done)
+        d->finished.wait(&d->mutex);
+    return std::move(entry->result);
+}
+
+auto MrlPrefetcher::forget(const Mrl &mrl) -> void
+{
+    QMutexLocker locker(&d->mutex);
+    const int idx = d->find(mrl.toUnique());
+    if (idx >= 0)
+        d->drop(d->entries.takeAt(idx));
+}
+
+auto MrlPrefetcher::clear() -> void
+{
+    QMutexLocker locker(&d->mutex);
+    for (auto &entry : d->entries)
+        d->drop(entry);
+    d->entries.clear();
+}
@@ -0,0 +1,47 @@
+#ifndef MRLPREFETCHER_HPP
+#define MRLPREFETCHER_HPP
+
+#include "mrl.hpp"
+#include "misc/encodinginfo.hpp"
+#include "misc/youtubedl.hpp"
+#include <QElapsedTimer>
+
+class MrlState;
+
+// Looks up saved state and external files of mrls in a worker thread as soon
+// as they are queued, so that on_load hook of mpv can take them without
+// waiting for storage. Results are keyed by unique mrl and taken only once.
+// Mrls expected to be played next can also be prepared to be opened quickly.
+class MrlPrefetcher {
+public:
+    struct Result {
+        bool found = false;                     // state is found in history
+        QSharedPointer<MrlState> state;         // null if never prefetched
+        QStringList audios, subtitles;          // autoloaded files
+        QMap<QString, EncodingInfo> encodings;  // detected for subtitles
+        YouTubeDL::Result youtube;              // resolved stream if prepared
+        QByteArray cookies;                     // for resolved stream
+        QElapsedTimer resolved;                 // invalid if not resolved
+        auto isValid() const -> bool { return !state.isNull(); }
+    };
+    using Lookup = std::function<Result(const Mrl&, bool prepare)>;
+    MrlPrefetcher();
+    ~MrlPrefetcher();
+    // lookup is called in worker thread
+    auto setLookup(Lookup &&lookup) -> void;
+    // ahead means mrl is not being loaded now but may be soon
+    // prepare is passed to lookup, which may touch disk or network for it
+    auto prefetch(const Mrl &mrl, bool ahead = false, bool prepare = false) -> void;
+    // waits if lookup is in progress, returns invalid result if not prefetched
+    auto take(const Mrl &mrl) -> Result;
+    auto forget(const Mrl &mrl) -> void;
+    auto clear() -> void;
+private:
+    class Job;
+    struct Entry;
+    using EntryPtr = QSharedPointer<Entry>;
+    struct Data;
+    Data *d;
+};
+
+#endif // MRLPREFETCHER_HPP
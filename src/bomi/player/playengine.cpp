@@ -191,14 +191,9 @@ PlayEngine::PlayEngine()
     d->updateMediaName();
     d->frames.measure.setTimer([=]()
         { d->info.video.output()->setFps(d->frames.measure.get()); }, 100000);
-    connect(&d->info.frameTimer, &QTimer::timeout, this, [=] () {
-        d->info.video.decoder()->setBitrate(d->mpv.get<int>("video-bitrate"));
-        d->info.video.setDelayedFrames(d->info.delayed);
-        d->info.video.setDroppedFrames(d->mpv.get<int64_t>("vo-drop-frame-count"));
-    });
+    connect(&d->info.frameTimer, &QTimer::timeout, this, [=] () { d->sampleStatistics(); });
     connect(d->info.video.output(), &VideoFormatObject::sizeChanged,
             d->preview, &VideoPreview::setSizeHint);
-    d->info.frameTimer.setInterval(100);
 
     _Debug("Make registrations and connections");
 
@@ -394,15 +389,14 @@ auto PlayEngine::setTrackSelected(StreamType type, int id, bool s) -> void
 auto PlayEngine::autoloadSubtitleFiles() -> void
 {
     clearSubtitleFiles();
-    MpvFileList files; QVector<SubComp> loads;
     d->mutex.lock();
-    _R(files, loads) = d->autoloadSubtitle(&d->params);
+    const auto files = d->autoloadFiles(StreamSubtitle);
     d->mutex.unlock();
-    for (auto &file : files.names) {
-        d->mpv.setAsync("options/subcp", d->assEncodings[file].name().toLatin1());
-        d->mpv.tellAsync("sub_add", MpvFile(file), "auto"_b);
-    }
-    d->setInclusiveSubtitles(loads);
+    // files which cannot be parsed are passed to mpv after detection
+    PendingSubtitles subs;
+    for (auto &file : files.names)
+        subs.tasks.push_back({ file, EncodingInfo(), true });
+    d->loadPendingSubtitles(&d->params, subs);
 }
 
 auto PlayEngine::autoloadAudioFiles() -> void
@@ -421,7 +415,10 @@ auto PlayEngine::reloadSubtitleFiles(const EncodingInfo &enc, bool detect) -> vo
         if (track.isExternal())
             d->sub_add(track.file(), d->encoding(track, enc, detect), track.isSelected());
     }
-    d->setInclusiveSubtitles(d->restoreInclusiveSubtitles(old2, enc, detect));
+    const auto tasks = d->inclusiveSubtitleTasks(old2, enc, detect);
+    d->subLoader.load(tasks, [=] (const QVector<SubtitleLoader::Result> &results) {
+        d->setInclusiveSubtitles(d->restoreInclusiveSubtitles(old2, results));
+    });
 }
 
 auto PlayEngine::reloadAudioFiles() -> void
@@ -722,6 +719,9 @@ auto PlayEngine::setMrl(const Mrl &mrl) -> void
 
 auto PlayEngine::load(const Mrl &mrl, bool tryResume, const QString &sub) -> void
 {
+    // reloading current one has to see the state saved when it ends
+    if (mrl != d->mrl)
+        d->prefetcher.prefetch(mrl);
     if (_Change(d->mrl, mrl)) {
         d->hasImage = mrl.isImage();
         d->updateMediaName();
@@ -731,6 +731,59 @@ auto PlayEngine::load(const Mrl &mrl, bool tryResume, const QString &sub) -> voi
         d->loadfile(d->mrl, tryResume, sub);
 }
 
+void PlayEngine::watchStatistics(bool watch)
+{
+    d->stats.watchers = qMax(0, d->stats.watchers + (watch ? 1 : -1));
+    d->updateStatisticsTimer();
+}
+
+static auto toVariant(const Mpv::Latency &l) -> QVariantMap
+{
+    QVariantList histogram;
+    for (auto count : l.bins)
+        histogram.push_back(count);
+    QVariantMap map;
+    map[u"count"_q] = l.count;
+    map[u"average"_q] = l.average();
+    map[u"p95"_q] = l.percentile(0.95);
+    map[u"max"_q] = l.max;
+    map[u"histogram"_q] = histogram;
+    return map;
+}
+
+QVariantMap PlayEngine::latencyReport() const
+{
+    QVariantMap report;
+    for (auto &s : d->mpv.latencyStats()) {
+        QVariantMap map;
+        map[u"hook"_q] = s.hook;
+        map[u"wait"_q] = toVariant(s.wait);
+        map[u"execution"_q] = toVariant(s.execution);
+        map[u"total"_q] = toVariant(s.total);
+        report[QString::fromLatin1(s.name)] = map;
+    }
+    return report;
+}
+
+void PlayEngine::resetLatencyReport()
+{
+    d->mpv.resetLatencyStats();
+    if (!d->stats.hooks.isEmpty()) {
+        d->stats.hooks.clear();
+        emit hookLatenciesChanged();
+    }
+}
+
+auto PlayEngine::hookLatencies() const -> QVariantList
+{
+    return d->stats.hooks;
+}
+
+auto PlayEngine::prefetch(const Mrl &mrl, bool next) -> void
+{
+    d->prefetcher.prefetch(mrl, true, next);
+}
+
 auto PlayEngine::time() const -> int
 {
     return d->time;
@@ -1325,6 +1378,14 @@ auto PlayEngine::captionEndTime() -> int
     return d->sr->finish(d->time);
 }
 
+int PlayEngine::seekToCaption(const QString &text)
+{
+    const int time = d->sr->find(text, d->time);
+    if (time >= 0)
+        seek(time);
+    return time;
+}
+
 auto PlayEngine::captionBeginTime(int direction) -> int
 {
     if (direction < 0)
@@ -1383,6 +1444,7 @@ auto PlayEngine::clearSubtitleFiles() -> void
         if (track.isExternal())
             d->mpv.tellAsync("sub_remove", track.id());
     }
+    d->subLoader.cancel();
     d->setInclusiveSubtitles(QVector<SubComp>());
 }
 
@@ -69,6 +69,7 @@ class PlayEngine : public QObject {
     Q_PROPERTY(bool muted READ isMuted WRITE setAudioMuted NOTIFY mutedChanged)
 
     Q_PROPERTY(int avSync READ avSync NOTIFY avSyncChanged)
+    Q_PROPERTY(QVariantList hookLatencies READ hookLatencies NOTIFY hookLatenciesChanged)
 
     Q_PROPERTY(State state READ state NOTIFY stateChanged)
     Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
@@ -114,6 +115,9 @@ public:
     auto speed() const -> double;
     auto state() const -> State;
     auto load(const Mrl &mrl, bool tryResume = true, const QString &sub = QString()) -> void;
+    // look up state and files of mrl in background before it is loaded,
+    // and prepare its stream to be opened quickly if it is next one
+    auto prefetch(const Mrl &mrl, bool next = false) -> void;
     auto setMrl(const Mrl &mrl) -> void;
     auto edition() const -> EditionObject*;
     auto chapter() const -> ChapterObject*;
@@ -143,6 +147,15 @@ public:
     auto captionBeginTime() -> int;
     auto captionBeginTime(int direction) -> int;
     auto captionEndTime() -> int;
+    // seeks to next caption containing text and returns its time or -1
+    Q_INVOKABLE int seekToCaption(const QString &text);
+    // frame statistics are sampled only while watched by anyone
+    Q_INVOKABLE void watchStatistics(bool watch);
+    // latencies of mpv hooks and async requests in us since last reset
+    Q_INVOKABLE QVariantMap latencyReport() const;
+    Q_INVOKABLE void resetLatencyReport();
+    // summary of hooks in ms, sampled with frame statistics
+    auto hookLatencies() const -> QVariantList;
     auto subtitleImage(const QRect &rect, QRectF *subRect = nullptr) const -> QImage;
     auto lastSubtitleUpdatedTime() const -> int;
 
@@ -298,6 +311,7 @@ public slots:
     void seek(int pos);
 signals:
     void currentTrackChanged(StreamType type);
+    void hookLatenciesChanged();
     void time_sChanged();
     void duration_sChanged();
     void begin_sChanged();
@@ -48,7 +48,10 @@ private:
 };
 
 PlayEngine::Data::Data(PlayEngine *engine)
-    : p(engine) { }
+    : p(engine)
+{
+    prefetcher.setLookup([=] (const Mrl &mrl, bool prepare) { return lookup(mrl, prepare); });
+}
 
 auto PlayEngine::Data::af(const MrlState *s) const -> QByteArray
 {
@@ -217,6 +220,8 @@ auto PlayEngine::Data::onLoad() -> void
     this->reload = -1;
     mutex.unlock();
 
+    // never wait for storage here if state has been looked up already
+    const auto fetched = prefetcher.take(mrl);
     bool found = false, resume = false;
     int start = -1;
     if (reload < 0) {
@@ -228,7 +233,11 @@ auto PlayEngine::Data::onLoad() -> void
         local->set_audio_tracks(StreamList());
         local->set_sub_tracks(StreamList());
         local->set_sub_tracks_inclusive(StreamList());
-        found = history->getState(local);
+        if (fetched.isValid()) {
+            if ((found = fetched.found))
+                history->restore(local, fetched.state.data());
+        } else
+            found = history->getState(local);
         resume = mpv.get<bool>("options/resume-playback") && this->resume;
         if (resume)
             start = local->resume_position();
@@ -293,43 +302,32 @@ auto PlayEngine::Data::onLoad() -> void
 
     if (found && local->audio_tracks().isValid())
         setFiles("file-local-options/audio-file"_b, "file-local-options/aid"_b, local->audio_tracks());
+    else if (fetched.isValid())
+        mpv.setAsync("file-local-options/audio-file", MpvFileList(fetched.audios));
     else {
         QMutexLocker locker(&mutex);
         mpv.setAsync("file-local-options/audio-file", autoloadFiles(StreamAudio));
     }
-    QVector<SubComp> loads;
-    auto loadSub = [&] (auto &&res) {
-        MpvFileList files, encs;
-        _R(files, loads) = res;
-        if (!files.names.isEmpty()) {
-            mpv.setAsync("options/subcp", assEncodings[files.names.front()].name().toLatin1());
-            mpv.setAsync("file-local-options/sub-file", files);
-        }
-        bool sel = false;
-        for (const auto &s : loads) {
-            sel = s.selection();
-            if (sel)
-                break;
-        }
-        if (sel && local->d->preferExternal)
-            mpv.setAsync("file-local-options/sid", "no"_b);
-        else
-            mpv.setAsync("file-local-options/sid", "auto"_b);
-    };
+    PendingSubtitles subs;
     if (sub.isEmpty()) {
         if (found && local->sub_tracks().isValid()) {
             setFiles("file-local-options/sub-file"_b, "file-local-options/sid"_b, local->sub_tracks());
-            loads = restoreInclusiveSubtitles(local->sub_tracks_inclusive(), EncodingInfo(), -1);
-        } else {
-            QMutexLocker locker(&mutex);
-            loadSub(autoloadSubtitle(local));
+            subs.tasks = inclusiveSubtitleTasks(local->sub_tracks_inclusive(), EncodingInfo(), true);
+            subs.mode = PendingSubtitles::Restore;
+        } else if (fetched.isValid())
+            subs = autoloadSubtitle(fetched.subtitles, fetched.encodings);
+        else {
+            mutex.lock();
+            const auto files = autoloadFiles(StreamSubtitle);
+            mutex.unlock();
+            subs = autoloadSubtitle(files);
         }
     } else {
-        QMutexLocker locker(&mutex);
-        loadSub(autoloadSubtitle(local, QStringList{sub}));
-        for (auto &comp : loads)
-            comp.selection() = true;
+        subs = autoloadSubtitle(QStringList{sub});
+        subs.mode = PendingSubtitles::Given;
     }
+    if (subs.mode != PendingSubtitles::Restore)
+        mpv.setAsync("file-local-options/sid", "auto"_b);
 
     local->set_last_played_date_time(QDateTime::currentDateTime());
     local->set_device(mrl.device());
@@ -373,6 +371,16 @@ auto PlayEngine::Data::onLoad() -> void
 
     if (file.data.startsWith("http://"_a, QCI) || file.data.startsWith("https://"_a, QCI)) {
         file = QUrl(file).toString(QUrl::FullyEncoded);
+        // signed stream urls expire, so stale one is resolved again
+        static constexpr const qint64 ResolvedTtl = 5 * 60 * 1000;
+        if (!fetched.youtube.mrl.isEmpty() && fetched.youtube.mrl == file && youtube
+                && fetched.resolved.isValid() && !fetched.resolved.hasExpired(ResolvedTtl)) {
+            // resolved in advance, so only cookies are left to be passed
+            QFile cookies(youtube->cookies());
+            if (cookies.open(QFile::WriteOnly | QFile::Truncate))
+                cookies.write(fetched.cookies);
+            ytResult = fetched.youtube;
+        }
         if (file != ytResult.mrl)
             ytResult.clear();
         if (yle && yle->supports(file)) {
@@ -440,7 +448,7 @@ auto PlayEngine::Data::onLoad() -> void
 
     mpv.setAsync("stream-open-filename", file.toMpv());
     mpv.flush();
-    _PostEvent(p, SyncMrlState, t.local, loads, ytResult);
+    _PostEvent(p, SyncMrlState, t.local, subs, ytResult);
     t.local.clear();
 
     mutex.lock();
@@ -497,14 +505,14 @@ auto PlayEngine::Data::observe() -> void
     };
 
     mpv.observeTime("avsync", avSync, [=] () { emit p->avSyncChanged(avSync); });
-    mpv.observe("time-pos", [=] () {
+    mpv.observeValue<double>("time-pos", [=] (double pos) {
         int ctime = 0;
         if (t.caching)
             ctime = s2ms(mpv.get<double>("demuxer-cache-time")) - t.offset;
         if (ctime != info.cache.time())
             QMetaObject::invokeMethod(&info.cache, "setTime",
                                       Qt::QueuedConnection, Q_ARG(int, ctime));
-        return s2ms(mpv.get<double>("time-pos")) - t.offset;
+        return s2ms(pos) - t.offset;
     }, [=] (int pos) {
         if (!_Change(time, pos))
             return;
@@ -543,23 +551,38 @@ auto PlayEngine::Data::observe() -> void
         info.video.setFrameCount(calcFrameCount(info.video.decoder()->fps(), duration));
     });
 
-    mpv.observe("chapter-list", [=] () {
-        const auto array = mpv.get<QVariant>("chapter-list").toList();
-        QVector<ChapterData> data(array.size());
-        for (int i=0; i<array.size(); ++i) {
-            const auto map = array[i].toMap();
-            data[i].number = i;
-            data[i].time = s2ms(map[u"time"_q].toDouble()) - t.offset;
-            data[i].name = map[u"title"_q].toString();
-            if (data[i].name.isEmpty())
-                data[i].name = _MSecToString(data[i].time, u"hh:mm:ss.zzz"_q);
-        }
+    mpv.observeNode("chapter-list", [=] (const mpv_node &node) {
+        QVector<ChapterData> data;
+        _ForEachMpvNode(node, [&] (const char*, const mpv_node &chapter) {
+            ChapterData c;
+            c.number = data.size();
+            _ForEachMpvNode(chapter, [&] (const char *key, const mpv_node &value) {
+                if (!qstrcmp(key, "time"))
+                    c.time = s2ms(_MpvNumber(value)) - t.offset;
+                else if (!qstrcmp(key, "title"))
+                    c.name = _MpvString(value);
+            });
+            if (c.name.isEmpty())
+                c.name = _MSecToString(c.time, u"hh:mm:ss.zzz"_q);
+            data.push_back(c);
+        });
         return data;
     }, [=] (auto &&data) {
-        for (auto chapter : info.chapters)
-            QQmlEngine::setObjectOwnership(chapter, QQmlEngine::JavaScriptOwnership);
+        // keep objects of chapters which have not changed
+        auto same = [&] (int i) {
+            const auto &m = info.chapters[i]->m;
+            return m.number == data[i].number && m.time == data[i].time
+                   && m.name == data[i].name;
+        };
+        int keep = 0;
+        while (keep < qMin(data.size(), info.chapters.size()) && same(keep))
+            ++keep;
+        if (keep == data.size() && keep == info.chapters.size())
+            return;
+        for (int i = keep; i < info.chapters.size(); ++i)
+            QQmlEngine::setObjectOwnership(info.chapters[i], QQmlEngine::JavaScriptOwnership);
         info.chapters.resize(data.size());
-        for (int i = 0; i < data.size(); ++i) {
+        for (int i = keep; i < data.size(); ++i) {
             info.chapters[i] = new ChapterObject;
             info.chapters[i]->set(data[i]);
         }
@@ -567,12 +590,24 @@ auto PlayEngine::Data::observe() -> void
         updateChapter(mpv.get<int>("chapter"));
     });
     mpv.observe("chapter", updateChapter);
-    mpv.observe("track-list", [=] () {
-        return toTracks(mpv.get<QVariant>("track-list"));
+    mpv.observeNode("track-list", [=] (const mpv_node &node) {
+        return toTracks(node);
     }, [=] (auto &&strms) {
-        params.set_video_tracks(strms[StreamVideo]);
-        params.set_audio_tracks(strms[StreamAudio]);
-        params.set_sub_tracks(strms[StreamSubtitle]);
+        // encodings of external subtitles are known only when they are added
+        const auto subs = params.sub_tracks();
+        for (auto &track : strms[StreamSubtitle]) {
+            if (!track.isExternal() || track.m_encoding.isValid())
+                continue;
+            if (auto old = subs.track(track.id()))
+                track.m_encoding = old->encoding();
+        }
+        // setters always notify, so leave unchanged lists as they are
+        if (params.video_tracks() != strms[StreamVideo])
+            params.set_video_tracks(strms[StreamVideo]);
+        if (params.audio_tracks() != strms[StreamAudio])
+            params.set_audio_tracks(strms[StreamAudio]);
+        if (subs != strms[StreamSubtitle])
+            params.set_sub_tracks(strms[StreamSubtitle]);
 
         auto audioOnly = !strms[StreamAudio].isEmpty();
         if (audioOnly && !strms[StreamVideo].isEmpty()) {
@@ -604,13 +639,18 @@ auto PlayEngine::Data::observe() -> void
             if (type == StreamSubtitle)
                 vr->setOsdVisible(current > 0);
         });
-    mpv.observe("metadata", [=] () {
-        const auto map = mpv.get<QVariant>("metadata").toMap();
+    mpv.observeNode("metadata", [=] (const mpv_node &node) {
         MetaData metaData;
-        metaData.m_title = map[u"title"_q].toString();
-        metaData.m_artist = map[u"artist"_q].toString();
-        metaData.m_genre = map[u"genre"_q].toString();
-        metaData.m_date = map[u"date"_q].toString();
+        _ForEachMpvNode(node, [&] (const char *key, const mpv_node &value) {
+            if (!qstrcmp(key, "title"))
+                metaData.m_title = _MpvString(value);
+            else if (!qstrcmp(key, "artist"))
+                metaData.m_artist = _MpvString(value);
+            else if (!qstrcmp(key, "genre"))
+                metaData.m_genre = _MpvString(value);
+            else if (!qstrcmp(key, "date"))
+                metaData.m_date = _MpvString(value);
+        });
         metaData.m_mrl = params.mrl();
         metaData.m_duration = length();
         return metaData;
@@ -681,6 +721,7 @@ auto PlayEngine::Data::observe() -> void
     mpv.observe("current-ao", [=] (MpvLatin1 &&ao) { info.audio.setDriver(ao); });
 
     mpv.observe("disc-mouse-on-button", [=] (bool on) { mouseOnButton = on; });
+    mpv.observeState("vo-drop-frame-count", [=] (qint64 n) { stats.dropped = n; });
 }
 
 auto PlayEngine::Data::request() -> void
@@ -829,6 +870,7 @@ auto PlayEngine::Data::process(QEvent *event) -> void
         }
         updateState(state);
         history->update(last.data(), false);
+        prefetcher.forget(last->mrl());
         emit p->finished(last->mrl(), eof);
         break;
     } case NotifySeek:
@@ -836,19 +878,24 @@ auto PlayEngine::Data::process(QEvent *event) -> void
         break;
     case SyncMrlState: {
         QSharedPointer<MrlState> ms;
-        QVector<SubComp> loads;
+        PendingSubtitles subs;
         YouTubeDL::Result ytr;
-        _TakeData(event, ms, loads, ytr);
+        _TakeData(event, ms, subs, ytr);
         emit p->beginSyncMrlState();
         params.m_mutex = nullptr;
-        sr->setComponents(loads);
+        subLoader.cancel();
+        sr->setComponents(QVector<SubComp>());
         mutex.lock();
         params.copyFrom(ms.data());
-        params.set_sub_tracks_inclusive(sr->toTrackList());
+        // restored tracks are kept to be saved even if loader is cancelled
+        // before it replaces them with loaded ones
+        if (subs.mode != PendingSubtitles::Restore || subs.tasks.isEmpty())
+            params.set_sub_tracks_inclusive(sr->toTrackList());
         mutex.unlock();
         params.m_mutex = &mutex;
         emit p->endSyncMrlState();
         history->update(&params, false);
+        loadPendingSubtitles(ms.data(), subs);
 
         qDeleteAll(info.streamings);
         info.streamings.clear();
@@ -883,7 +930,7 @@ auto PlayEngine::Data::takeSnapshot() -> void
 
 auto PlayEngine::Data::renderVideoFrame(Fbo *frame, Fbo *osd, const QMargins &m) -> void
 {
-    info.delayed = mpv.render(frame, osd, m);
+    stats.delayed = mpv.render(frame, osd, m);
     frames.measure.push(++frames.drawn);
 
     _Trace("PlayEngine::Data::renderVideoFrame(): "
@@ -907,32 +954,66 @@ auto PlayEngine::Data::toTracks(const QVariant &var) -> QVector<StreamList>
         auto track = StreamTrack::fromMpvData(var);
         streams[track.type()].insert(track);
     }
-    auto &subs = streams[StreamSubtitle];
-    if (!subs.isEmpty()) {
-        QMutexLocker locker(&mutex);
-        for (auto &track : subs) {
-            if (track.isExternal())
-                track.m_encoding = assEncodings.take(track.file());
+    takeEncodings(streams[StreamSubtitle]);
+    return streams;
+}
+
+auto PlayEngine::Data::toTracks(const mpv_node &node) -> QVector<StreamList>
+{
+    QVector<StreamList> streams(3);
+    streams[StreamVideo] = { StreamVideo };
+    streams[StreamAudio] = { StreamAudio };
+    streams[StreamSubtitle] = { StreamSubtitle };
+    _ForEachMpvNode(node, [&] (const char*, const mpv_node &entry) {
+        const auto track = StreamTrack::fromMpvNode(entry);
+        if (track.isValid())
+            streams[track.type()].insert(track);
+    });
+    takeEncodings(streams[StreamSubtitle]);
+    return streams;
+}
+
+auto PlayEngine::Data::takeEncodings(StreamList &subs) -> void
+{
+    if (subs.isEmpty())
+        return;
+    QMutexLocker locker(&mutex);
+    for (auto &track : subs) {
+        if (track.isExternal())
+            track.m_encoding = assEncodings.take(track.file());
+    }
+}
+
+auto PlayEngine::Data::inclusiveSubtitleTasks(const StreamList &tracks, const EncodingInfo &enc, bool detect) -> QVector<SubtitleLoader::Task>
+{
+    Q_ASSERT(tracks.type() == StreamInclusiveSubtitle);
+    QVector<SubtitleLoader::Task> tasks;
+    QSet<QString> files;
+    for (auto &track : tracks) {
+        if (!files.contains(track.file())) {
+            files.insert(track.file());
+            tasks.push_back(subtitleTask(track, enc, detect));
         }
     }
-    return streams;
+    return tasks;
 }
 
-auto PlayEngine::Data::restoreInclusiveSubtitles(const StreamList &tracks, const EncodingInfo &enc, bool detect) -> QVector<SubComp>
+auto PlayEngine::Data::restoreInclusiveSubtitles(const StreamList &tracks, const QVector<SubtitleLoader::Result> &results) -> QVector<SubComp>
 {
     Q_ASSERT(tracks.type() == StreamInclusiveSubtitle);
     QVector<SubComp> ret;
     QMap<QString, QMap<QString, SubComp>> subMap;
+    for (auto &result : results) {
+        if (!result.isParsed())
+            continue;
+        auto &comps = subMap[result.file];
+        for (int i = 0; i < result.subtitle.size(); ++i)
+            comps.insert(result.subtitle[i].language(), result.subtitle[i]);
+    }
     for (auto &track : tracks) {
         auto it = subMap.find(track.file());
-        if (it == subMap.end()) {
-            it = subMap.insert(track.file(), QMap<QString, SubComp>());
-            Subtitle sub;
-            if (!sub.load(track.file(), encoding(track, enc, detect)))
-                continue;
-            for (int i = 0; i < sub.size(); ++i)
-                it->insert(sub[i].language(), sub[i]);
-        }
+        if (it == subMap.end())
+            continue;
         auto iit = it->find(track.language());
         if (iit != it->end()) {
             iit->selection() = track.isSelected();
@@ -942,6 +1023,48 @@ auto PlayEngine::Data::restoreInclusiveSubtitles(const StreamList &tracks, const
     return ret;
 }
 
+auto PlayEngine::Data::takeComponents(const QVector<SubtitleLoader::Result> &results, bool select) -> QVector<SubComp>
+{
+    QVector<SubComp> loads;
+    for (auto &result : results) {
+        if (result.isParsed()) {
+            for (int i = 0; i < result.subtitle.size(); ++i)
+                loads.push_back(result.subtitle[i]);
+        } else if (!result.file.isEmpty())
+            sub_add(result.file, result.encoding, select);
+    }
+    return loads;
+}
+
+auto PlayEngine::Data::loadPendingSubtitles(const MrlState *s, const PendingSubtitles &pending) -> void
+{
+    if (pending.tasks.isEmpty())
+        return;
+    if (pending.mode == PendingSubtitles::Restore) {
+        const auto tracks = s->sub_tracks_inclusive();
+        subLoader.load(pending.tasks, [=] (const QVector<SubtitleLoader::Result> &results) {
+            sr->addComponents(restoreInclusiveSubtitles(tracks, results));
+            syncInclusiveSubtitles();
+        });
+        return;
+    }
+    const auto mode = pending.mode;
+    subLoader.load(pending.tasks, [=] (const QVector<SubtitleLoader::Result> &results) {
+        auto loads = takeComponents(results, mode == PendingSubtitles::Given);
+        if (mode == PendingSubtitles::Given) {
+            for (auto &comp : loads)
+                comp.selection() = true;
+        } else
+            autoselect(&params, loads);
+        const bool sel = std::any_of(loads.begin(), loads.end(),
+                                     [] (const SubComp &c) { return c.selection(); });
+        if (sel && params.d->preferExternal)
+            mpv.setAsync("sid", "no"_b);
+        sr->addComponents(loads);
+        syncInclusiveSubtitles();
+    });
+}
+
 auto PlayEngine::Data::autoloadFiles(StreamType type) -> MpvFileList
 {
     auto &a = streams[type].autoloader;
@@ -996,29 +1119,77 @@ auto PlayEngine::Data::autoselect(const MrlState *s, QVector<SubComp> &loads) ->
         loads[selected[i]].selection() = true;
 }
 
-auto PlayEngine::Data::autoloadSubtitle(const MrlState *s, const MpvFileList &subs)
--> T<MpvFileList, QVector<SubComp>>
+auto PlayEngine::Data::autoloadSubtitle(const MpvFileList &subs,
+                                        const QMap<QString, EncodingInfo> &detected)
+-> PendingSubtitles
 {
-    MpvFileList files;
-    QVector<SubComp> loads;
+    // nothing is read here: loader detects encoding if not prefetched and
+    // files which cannot be parsed are passed to mpv after that
+    PendingSubtitles pending;
     for (auto &file : subs.names) {
-       Subtitle sub;
-       const auto enc = EncodingInfo::detect(EncodingInfo::Subtitle, file);
-       if (sub.load(file, enc)) {
-           for (int i = 0; i < sub.size(); ++i)
-               loads.push_back(sub[i]);
-       } else {
-           files.names.push_back(file);
-           assEncodings[file] = enc;
-       }
+        auto it = detected.find(file);
+        if (it != detected.end())
+            pending.tasks.push_back({ file, *it, false });
+        else
+            pending.tasks.push_back({ file, EncodingInfo(), true });
     }
-    autoselect(s, loads);
-    return _T(files, loads);
+    return pending;
+}
+
+auto PlayEngine::Data::lookup(const Mrl &mrl, bool prepare) -> MrlPrefetcher::Result
+{
+    MrlPrefetcher::Result result;
+    result.state.reset(new MrlState);
+    result.state->blockSignals(true);
+    result.state->set_mrl(mrl.toUnique());
+    result.found = history->getState(result.state.data());
+    mutex.lock();
+    const auto audio = streams[StreamAudio], sub = streams[StreamSubtitle];
+    mutex.unlock();
+    if (audio.autoloader.enabled)
+        result.audios = audio.autoloader.autoload(mrl, audio.ext);
+    if (sub.autoloader.enabled)
+        result.subtitles = sub.autoloader.autoload(mrl, sub.ext);
+    for (auto &file : result.subtitles)
+        result.encodings[file] = EncodingInfo::detect(EncodingInfo::Subtitle, file);
+    if (prepare)
+        this->prepare(mrl, result);
+    return result;
 }
 
-auto PlayEngine::Data::autoloadSubtitle(const MrlState *s) -> T<MpvFileList, QVector<SubComp>>
+auto PlayEngine::Data::prepare(const Mrl &mrl, MrlPrefetcher::Result &result) -> void
 {
-    return autoloadSubtitle(s, autoloadFiles(StreamSubtitle));
+    if (mrl.isLocalFile()) {
+        // read head of file where demuxer probes into page cache,
+        // which saves round trips for files on network shares
+        QFile file(mrl.toLocalFile());
+        if (!file.open(QFile::ReadOnly))
+            return;
+        static constexpr const qint64 Head = 8 * 1024 * 1024, Chunk = 1024 * 1024;
+        QByteArray buffer(Chunk, Qt::Uninitialized);
+        for (qint64 read = 0; read < Head; ) {
+            const auto len = file.read(buffer.data(), Chunk);
+            if (len <= 0)
+                break;
+            read += len;
+        }
+        return;
+    }
+    const auto url = QUrl(mrl.toString()).toString(QUrl::FullyEncoded);
+    if (!youtube || !url.startsWith("http"_a, Qt::CaseInsensitive) || (yle && yle->supports(url)))
+        return;
+    // resolve stream with own instance since youtube is used by on_load hook
+    YouTubeDL ytdl;
+    ytdl.setProgram(youtube->program());
+    ytdl.setUserAgent(youtube->userAgent());
+    ytdl.setTimeout(youtube->timeout());
+    if (!ytdl.run(url))
+        return;
+    result.youtube = ytdl.result();
+    result.resolved.start();
+    QFile cookies(ytdl.cookies());
+    if (cookies.open(QFile::ReadOnly))
+        result.cookies = cookies.readAll();
 }
 
 auto PlayEngine::Data::localCopy() -> QSharedPointer<MrlState>
@@ -1046,10 +1217,47 @@ auto PlayEngine::Data::updateState(State s) -> void
             emit p->stoppedChanged();
         if (check(Running))
             emit p->runningChanged();
-        if (p->isRunning())
-            info.frameTimer.start();
-        else
-            info.frameTimer.stop();
+        updateStatisticsTimer();
+    }
+}
+
+auto PlayEngine::Data::sampleStatistics() -> void
+{
+    if (stats.watchers < 1) {
+        // keep ring from filling up so that first watcher gets fresh samples
+        vr->frameTimingSamples()->drain([] (const FrameTimingSample&) { });
+        return;
+    }
+    info.video.setDelayedFrames(stats.delayed);
+    info.video.setDroppedFrames(stats.dropped);
+    info.video.frameTiming()->update(vr->frameTimingSamples());
+    QVariantList hooks;
+    for (auto &s : mpv.latencyStats()) {
+        if (!s.hook)
+            continue;
+        QVariantMap map;
+        map[u"name"_q] = QString::fromLatin1(s.name);
+        map[u"count"_q] = s.total.count;
+        map[u"average"_q] = s.total.average() * 1e-3;
+        map[u"p95"_q] = s.total.percentile(0.95) * 1e-3;
+        map[u"max"_q] = s.total.max * 1e-3;
+        map[u"execution"_q] = s.execution.average() * 1e-3;
+        hooks.push_back(map);
+    }
+    if (_Change(stats.hooks, hooks))
+        emit p->hookLatenciesChanged();
+}
+
+auto PlayEngine::Data::updateStatisticsTimer() -> void
+{
+    if (!p->isRunning()) {
+        info.frameTimer.stop();
+        return;
+    }
+    const int interval = stats.watchers > 0 ? 100 : 1000;
+    if (!info.frameTimer.isActive() || info.frameTimer.interval() != interval) {
+        sampleStatistics();
+        info.frameTimer.start(interval);
     }
 }
 
@@ -1068,6 +1276,8 @@ auto PlayEngine::Data::setWaitings(Waitings w, bool set) -> void
 auto PlayEngine::Data::clearTimings() -> void
 {
     frames.measure.reset();
+    stats.delayed = 0;
+    stats.dropped = 0;
     info.video.setDroppedFrames(0);
     info.video.setDelayedFrames(0);
     info.video.output()->setFps(0);
@@ -1094,25 +1304,16 @@ auto PlayEngine::Data::addSubtitleFiles(const QVector<SubtitleWithEncoding> &sub
 {
     if (subs.isEmpty())
         return;
-    QVector<SubComp> loaded;
-    for (auto &s : subs) {
-        const auto enc = EncodingInfo::detect(EncodingInfo::Subtitle, s.encoding, s.file);
-        Subtitle sub;
-        if (sub.load(s.file, enc)) {
-            for (int i = 0; i < sub.size(); ++i) {
-                loaded.push_back(sub[i]);
-                loaded.back().selection() = true;
-            }
-        } else {
-            mpv.setAsync("options/subcp", enc.name().toLatin1());
-            mpv.tellAsync("sub_add", MpvFile(s.file), "auto"_b);
-            mutex.lock();
-            assEncodings[s.file] = enc;
-            mutex.unlock();
-        }
-    }
-    sr->addComponents(loaded);
-    syncInclusiveSubtitles();
+    QVector<SubtitleLoader::Task> tasks;
+    for (auto &s : subs)
+        tasks.push_back({ s.file, s.encoding, true });
+    subLoader.load(tasks, [=] (const QVector<SubtitleLoader::Result> &results) {
+        auto loaded = takeComponents(results);
+        for (auto &comp : loaded)
+            comp.selection() = true;
+        sr->addComponents(loaded);
+        syncInclusiveSubtitles();
+    });
 }
 
 auto PlayEngine::Data::updateSubtitleStyle() -> void
@@ -8,6 +8,7 @@
 #include "avinfoobject.hpp"
 #include "streamtrack.hpp"
 #include "historymodel.hpp"
+#include "mrlprefetcher.hpp"
 #include "misc/autoloader.hpp"
 #include "misc/youtubedl.hpp"
 #include "misc/osdstyle.hpp"
@@ -21,6 +22,7 @@
 #include "video/videopreview.hpp"
 #include "subtitle/subtitle.hpp"
 #include "subtitle/subtitlerenderer.hpp"
+#include "subtitle/subtitleloader.hpp"
 #include "enum/codecid.hpp"
 #include "enum/framebufferobjectformat.hpp"
 #include "opengl/openglframebufferobject.hpp"
@@ -60,6 +62,13 @@ struct SubtitleWithEncoding {
     EncodingInfo encoding;
 };
 
+// subtitles found in on_load hook, parsed in background after SyncMrlState
+struct PendingSubtitles {
+    enum Mode { Autoload, Given, Restore };
+    QVector<SubtitleLoader::Task> tasks;
+    Mode mode = Autoload;
+};
+
 struct PlayEngine::Data {
     Data(PlayEngine *engine);
     PlayEngine *p = nullptr;
@@ -69,6 +78,7 @@ struct PlayEngine::Data {
     VideoPreview *preview = nullptr;
     AudioController *ac = nullptr;
     SubtitleRenderer *sr = nullptr;
+    SubtitleLoader subLoader;
     VideoProcessor *vp = nullptr;
     FramebufferObjectFormat fboFormat = FramebufferObjectFormat::Auto;
     QByteArray playingVideo, playingAudio;
@@ -84,7 +94,7 @@ struct PlayEngine::Data {
 
     struct {
         MediaObject media;
-        VideoObject video; QTimer frameTimer; int delayed = 0;
+        VideoObject video; QTimer frameTimer;
         AudioObject audio;
         SubtitleObject subtitle;
         QVector<EditionChapterObject*> chapters, editions;
@@ -94,6 +104,15 @@ struct PlayEngine::Data {
         CacheInfoObject cache;
     } info;
 
+    // pushed by render and playloop threads, sampled by info.frameTimer
+    // only while someone watches statistics and discarded otherwise
+    struct {
+        std::atomic<int> delayed{0};
+        std::atomic<qint64> dropped{0};
+        int watchers = 0;
+        QVariantList hooks;
+    } stats;
+
     MetaData metaData;
     OsdStyle subStyle;
     HistoryModel *history = nullptr;
@@ -135,26 +154,38 @@ struct PlayEngine::Data {
     struct { QImage osd, frame; bool take = false; int time = 0; } ss;
     QPoint mouse;
 
+    MrlPrefetcher prefetcher; // uses members above in its thread
+
     auto resync(bool force = false) -> void;
     auto updateSubtitleStyle() -> void;
     auto updateState(State s) -> void;
     auto setWaitings(Waitings w, bool set) -> void;
     auto clearTimings() -> void;
+    auto sampleStatistics() -> void;
+    auto updateStatisticsTimer() -> void;
     auto setInclusiveSubtitles(const QVector<SubComp> &loaded) -> void
         { setInclusiveSubtitles(&params, loaded); }
     auto setInclusiveSubtitles(MrlState *s, const QVector<SubComp> &loaded) -> void
         { sr->setComponents(loaded); s->set_sub_tracks_inclusive(sr->toTrackList()); }
     auto syncInclusiveSubtitles() -> void
         { params.set_sub_tracks_inclusive(sr->toTrackList()); }
+    static auto inclusiveSubtitleTasks(const StreamList &tracks,
+        const EncodingInfo &enc, bool detect) -> QVector<SubtitleLoader::Task>;
     static auto restoreInclusiveSubtitles(const StreamList &tracks,
-        const EncodingInfo &enc, bool detect) -> QVector<SubComp>;
+        const QVector<SubtitleLoader::Result> &results) -> QVector<SubComp>;
+    auto takeComponents(const QVector<SubtitleLoader::Result> &results,
+                        bool select = false) -> QVector<SubComp>;
+    auto loadPendingSubtitles(const MrlState *s, const PendingSubtitles &pending) -> void;
     auto audio_add(const QString &file, bool select) -> void
         { mpv.tellAsync("audio_add", MpvFile(file), select ? "select"_b : "auto"_b); }
     auto sub_add(const QString &file, const EncodingInfo &enc, bool select) -> void;
     auto autoselect(const MrlState *s, QVector<SubComp> &loads) -> void;
     auto autoloadFiles(StreamType type) -> MpvFileList;
-    auto autoloadSubtitle(const MrlState *s) -> T<MpvFileList, QVector<SubComp>>;
-    auto autoloadSubtitle(const MrlState *s, const MpvFileList &files) -> T<MpvFileList, QVector<SubComp>>;
+    static auto autoloadSubtitle(const MpvFileList &files,
+                                 const QMap<QString, EncodingInfo> &detected = {})
+        -> PendingSubtitles;
+    auto lookup(const Mrl &mrl, bool prepare) -> MrlPrefetcher::Result;
+    auto prepare(const Mrl &mrl, MrlPrefetcher::Result &result) -> void;
 
     auto af(const MrlState *s) const -> QByteArray;
     auto vf(const MrlState *s) const -> QByteArray;
@@ -172,6 +203,8 @@ struct PlayEngine::Data {
     auto updateMediaName(const QString &name = QString()) -> void;
 
     auto toTracks(const QVariant &var) -> QVector<StreamList>;
+    auto toTracks(const mpv_node &node) -> QVector<StreamList>;
+    auto takeEncodings(StreamList &subs) -> void;
     auto refresh() -> void {mpv.tellAsync("frame_step"); mpv.tell("frame_back_step");}
     auto observe() -> void;
     auto process(QEvent *event) -> void;
@@ -192,12 +225,17 @@ struct PlayEngine::Data {
     auto request() -> void;
 
     static auto encoding(const StreamTrack &track, const EncodingInfo &enc, bool detect) -> EncodingInfo
+    {
+        const auto task = subtitleTask(track, enc, detect);
+        return task.detect ? EncodingInfo::detect(EncodingInfo::Subtitle, task.file) : task.encoding;
+    }
+    static auto subtitleTask(const StreamTrack &track, const EncodingInfo &enc, bool detect) -> SubtitleLoader::Task
     {
         if (enc.isValid())
-            return enc;
+            return { track.file(), enc, false };
         if (!detect && track.encoding().isValid())
-            return track.encoding();
-        return EncodingInfo::detect(EncodingInfo::Subtitle, track.file());
+            return { track.file(), track.encoding(), false };
+        return { track.file(), EncodingInfo(), true };
     }
     auto setSubtitleFiles(const QVector<SubtitleWithEncoding> &subs) -> void;
     auto addSubtitleFiles(const QVector<SubtitleWithEncoding> &subs) -> void;
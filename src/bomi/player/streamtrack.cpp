@@ -1,6 +1,7 @@
 #include "streamtrack.hpp"
 #include "subtitle/subtitle.hpp"
 #include "misc/locale.hpp"
+#include "mpv_property.hpp"
 
 SIA type2str(StreamType type) -> QString
 {
@@ -94,20 +95,56 @@ auto StreamTrack::fromMpvData(const QVariant &mpv) -> StreamTrack
     track.m_default = map[u"default"_q].toBool();
     track.m_id = map[u"id"_q].toInt();
     track.m_lang = map[u"lang"_q].toString();
-    if (_InRange(2, track.m_lang.size(), 3) && _IsAlphabet(track.m_lang))
-        track.m_displayLang = Locale::isoToNativeName(track.m_lang);
     track.m_title = map[u"title"_q].toString();
     track.m_file = map[u"external-filename"_q].toString();
-    if (!track.m_file.isEmpty()) {
-        if (track.m_file.contains("googlevideo.com/videoplayback"_a))
-            track.m_title.clear();
-        else
-            track.m_title = QFileInfo(track.m_file).fileName();
-    }
     track.m_selected = map[u"selected"_q].toBool();
+    track.fillFromMpv();
     return track;
 }
 
+auto StreamTrack::fromMpvNode(const mpv_node &node) -> StreamTrack
+{
+    if (node.format != MPV_FORMAT_NODE_MAP)
+        return StreamTrack();
+    StreamTrack track;
+    _ForEachMpvNode(node, [&] (const char *key, const mpv_node &value) {
+        if (!qstrcmp(key, "type"))
+            track.m_type = str2type(_MpvString(value));
+        else if (!qstrcmp(key, "id"))
+            track.m_id = _MpvNumber(value, -1);
+        else if (!qstrcmp(key, "albumart"))
+            track.m_albumart = _MpvFlag(value);
+        else if (!qstrcmp(key, "default"))
+            track.m_default = _MpvFlag(value);
+        else if (!qstrcmp(key, "selected"))
+            track.m_selected = _MpvFlag(value);
+        else if (!qstrcmp(key, "codec"))
+            track.m_codec = _MpvString(value);
+        else if (!qstrcmp(key, "lang"))
+            track.m_lang = _MpvString(value);
+        else if (!qstrcmp(key, "title"))
+            track.m_title = _MpvString(value);
+        else if (!qstrcmp(key, "external-filename"))
+            track.m_file = _MpvString(value);
+    });
+    if (track.m_type == StreamUnknown)
+        return StreamTrack();
+    track.fillFromMpv();
+    return track;
+}
+
+auto StreamTrack::fillFromMpv() -> void
+{
+    if (_InRange(2, m_lang.size(), 3) && _IsAlphabet(m_lang))
+        m_displayLang = Locale::isoToNativeName(m_lang);
+    if (!m_file.isEmpty()) {
+        if (m_file.contains("googlevideo.com/videoplayback"_a))
+            m_title.clear();
+        else
+            m_title = QFileInfo(m_file).fileName();
+    }
+}
+
 auto StreamTrack::fromSubComp(const SubComp &comp) -> StreamTrack
 {
     StreamTrack track;
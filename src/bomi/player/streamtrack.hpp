@@ -6,6 +6,7 @@
 enum StreamType { StreamAudio = 0, StreamVideo, StreamSubtitle, StreamInclusiveSubtitle, StreamUnknown };
 
 class SubComp;
+struct mpv_node;
 
 class StreamTrack {
     Q_DECLARE_TR_FUNCTIONS(StreamTrack)
@@ -36,10 +37,13 @@ public:
     static auto typeDescription(StreamType type, bool albumart = false) -> QString;
     static auto fromJson(const QJsonObject &json) -> StreamTrack;
     static auto fromMpvData(const QVariant &mpv) -> StreamTrack;
+    // reads an entry of track-list without converting it into QVariant
+    static auto fromMpvNode(const mpv_node &node) -> StreamTrack;
     static auto fromSubComp(const SubComp &comp) -> StreamTrack;
 private:
     friend class PlayEngine;
     friend class StreamList;
+    auto fillFromMpv() -> void;
     StreamType m_type = StreamUnknown;
     int m_id = -1;
     QString m_title, m_lang, m_file, m_codec, m_displayLang;
@@ -111,6 +111,7 @@ private:
     P1(QString, sub_ext, {}, "value")
     P0(int, sub_enc_accuracy, defaultSubtitleEncodingDetectionAccuracy())
     P0(int, ms_per_char, 500)
+    P0(int, sub_prerender_window, 30)
     P0(OsdStyle, sub_style, {})
     P0(bool, sub_prefer_external, true)
 
@@ -1,6 +1,71 @@
 #include "simplevertexitem.hpp"
 #include <QSGFlatColorMaterial>
 
+// same as QSGFlatColorMaterial but draw calls are wrapped by benchmark scope
+struct ScopedColorShader : public QSGMaterialShader {
+    ScopedColorShader(OpenGLBenchmarker::Scope scope): m_scope(scope) { }
+    auto vertexShader() const -> const char* final
+    {
+        return R"(
+            uniform mat4 qt_Matrix;
+            attribute vec4 aPosition;
+            void main() {
+                gl_Position = qt_Matrix * aPosition;
+            }
+        )";
+    }
+    auto fragmentShader() const -> const char* final
+    {
+        return R"(
+            uniform vec4 color;
+            void main() {
+                gl_FragColor = color;
+            }
+        )";
+    }
+    auto attributeNames() const -> const char *const* final
+    {
+        static const char *const names[] = { "aPosition", nullptr };
+        return names;
+    }
+    auto initialize() -> void final
+    {
+        loc_matrix = program()->uniformLocation("qt_Matrix");
+        loc_color = program()->uniformLocation("color");
+    }
+    auto updateState(const RenderState &state,
+                     QSGMaterial *new_, QSGMaterial *) -> void final
+    {
+        if (state.isMatrixDirty())
+            program()->setUniformValue(loc_matrix, state.combinedMatrix());
+        const auto c = static_cast<QSGFlatColorMaterial*>(new_)->color();
+        const float a = c.alphaF() * state.opacity();
+        program()->setUniformValue(loc_color, QVector4D(c.redF() * a,
+                                                        c.greenF() * a,
+                                                        c.blueF() * a, a));
+    }
+    auto activate() -> void final
+        { OpenGLBenchmarker::instance().begin(m_scope); }
+    auto deactivate() -> void final
+        { OpenGLBenchmarker::instance().end(m_scope); }
+private:
+    OpenGLBenchmarker::Scope m_scope;
+    int loc_matrix = -1, loc_color = -1;
+};
+
+struct ScopedColorMaterial : public QSGFlatColorMaterial {
+    ScopedColorMaterial(OpenGLBenchmarker::Scope scope): m_scope(scope) { }
+    auto type() const -> QSGMaterialType* final
+    {
+        static QSGMaterialType types[OpenGLBenchmarker::ScopeCount];
+        return &types[m_scope];
+    }
+    auto createShader() const -> QSGMaterialShader* final
+        { return new ScopedColorShader(m_scope); }
+private:
+    OpenGLBenchmarker::Scope m_scope;
+};
+
 SimpleVertexItem::SimpleVertexItem(QQuickItem *parent)
     : VertexDrawItem<OGL::PositionVertex>(parent)
 {
@@ -12,6 +77,8 @@ SimpleVertexItem::~SimpleVertexItem() {
 
 auto SimpleVertexItem::createMaterial() const -> QSGMaterial*
 {
+    if (m_scope != OpenGLBenchmarker::ScopeCount)
+        return new ScopedColorMaterial(m_scope);
     return new QSGFlatColorMaterial;
 }
 
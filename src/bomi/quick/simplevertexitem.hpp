@@ -3,6 +3,7 @@
 
 #include "opengldrawitem.hpp"
 #include "opengl/openglvertex.hpp"
+#include "opengl/openglbenchmarker.hpp"
 
 class SimpleVertexItem : public VertexDrawItem<OGL::PositionVertex> {
     Q_OBJECT
@@ -12,12 +13,16 @@ public:
     ~SimpleVertexItem();
     auto color() const -> QColor { return m_color; }
     auto setColor(const QColor &color) -> void;
+    // measure draw calls of this item; call before the first update
+    auto setBenchmarkScope(OpenGLBenchmarker::Scope scope) -> void
+        { m_scope = scope; }
 signals:
     void colorChanged();
 private:
     QSGMaterial *createMaterial() const override final;
     QSGMaterial *updateMaterial(QSGMaterial *material) override final;
     QColor m_color;
+    OpenGLBenchmarker::Scope m_scope = OpenGLBenchmarker::ScopeCount;
 };
 
 #endif // SIMPLEVERTEXITEM_HPP
@@ -1,4 +1,102 @@
 #include "richtextdocument.hpp"
+#include <QThreadStorage>
+#include <list>
+
+struct RichTextDocument::Layout {
+    ~Layout() { qDeleteAll(rubies); }
+    QTextLayout block;
+    QVector<QTextLayout*> rubies;
+    double height = 0.0, width = -1.0;
+    bool words = false; // has any line with words
+    QVector<QRectF> boxes;
+};
+
+static auto operator == (const RichTextBlock &lhs, const RichTextBlock &rhs) -> bool
+{
+    if (lhs.text != rhs.text || lhs.paragraph != rhs.paragraph
+            || lhs.formats.size() != rhs.formats.size()
+            || lhs.rubies.size() != rhs.rubies.size())
+        return false;
+    for (int i = 0; i < lhs.formats.size(); ++i) {
+        const auto &l = lhs.formats[i], &r = rhs.formats[i];
+        if (l.begin != r.begin || l.end != r.end || l.style != r.style)
+            return false;
+    }
+    for (int i = 0; i < lhs.rubies.size(); ++i) {
+        const auto &l = lhs.rubies[i], &r = rhs.rubies[i];
+        if (l.rb_begin != r.rb_begin || l.rb_end != r.rb_end
+                || !(l.rt_block == r.rt_block))
+            return false;
+    }
+    return true;
+}
+
+static auto qHash(const RichTextBlock &block, uint seed = 0) -> uint
+{
+    seed = qHash(block.text, seed);
+    for (auto &ruby : block.rubies)
+        seed = qHash(ruby.rt_block.text, seed ^ (uint)ruby.rb_begin);
+    return seed ^ (uint)block.formats.size();
+}
+
+// Shaping and line breaking of a block only depends on its content,
+// the base format, text option, width and whether it comes first.
+// Repeated lines share laid out blocks through this cache.
+// QTextLayout cannot be shared between threads, so each has its own.
+class RichTextLayoutCache {
+    using Layout = QSharedPointer<const RichTextDocument::Layout>;
+public:
+    struct Key {
+        RichTextBlock block;
+        QTextCharFormat format;
+        int alignment = 0, wrap = 0;
+        double width = 0, line = 0, paragraph = 0;
+        bool first = true;
+        auto operator == (const Key &rhs) const -> bool
+        {
+            return first == rhs.first && width == rhs.width
+                && line == rhs.line && paragraph == rhs.paragraph
+                && alignment == rhs.alignment && wrap == rhs.wrap
+                && block == rhs.block && format == rhs.format;
+        }
+        friend auto qHash(const Key &key, uint seed = 0) -> uint
+        {
+            const double values[] = { key.width, key.line, key.paragraph };
+            seed = qHashBits(values, sizeof(values), seed);
+            seed ^= (uint)key.alignment ^ ((uint)key.wrap << 8) ^ ((uint)key.first << 16);
+            return ::qHash(key.block, seed);
+        }
+    };
+    static auto local() -> RichTextLayoutCache&
+    {
+        static QThreadStorage<RichTextLayoutCache*> storage;
+        if (!storage.hasLocalData())
+            storage.setLocalData(new RichTextLayoutCache);
+        return *storage.localData();
+    }
+    auto find(const Key &key) -> Layout
+    {
+        auto it = m_index.find(key);
+        if (it == m_index.end())
+            return Layout();
+        m_lru.splice(m_lru.begin(), m_lru, *it);
+        return m_lru.front().second;
+    }
+    auto insert(const Key &key, const Layout &layout) -> void
+    {
+        m_lru.emplace_front(key, layout);
+        m_index.insert(key, m_lru.begin());
+        while ((int)m_lru.size() > Capacity) {
+            m_index.remove(m_lru.back().first);
+            m_lru.pop_back();
+        }
+    }
+private:
+    static constexpr int Capacity = 512;
+    using Entry = std::pair<Key, Layout>;
+    std::list<Entry> m_lru; // most recently used first
+    QHash<Key, std::list<Entry>::iterator> m_index;
+};
 
 RichTextDocument::RichTextDocument()
 {
@@ -27,11 +125,8 @@ RichTextDocument::~RichTextDocument()
 
 auto RichTextDocument::freeLayouts() -> void
 {
-    for (auto &layout : m_layouts) {
-        qDeleteAll(layout->rubies);
-        _Delete(layout);
-    }
     m_layouts.clear();
+    m_offsets.clear();
 }
 
 auto RichTextDocument::operator = (const RichTextDocument &rhs)
@@ -140,160 +235,152 @@ static QTextOption makeRubyOption() {
 
 static const QTextOption rubyOption = makeRubyOption();
 
-auto RichTextDocument::doLayout(double maxWidth) -> void
+static auto setFormats(QTextLayout *layout, const RichTextBlock &block,
+                       const QTextCharFormat &base, bool ruby) -> void
 {
-    if (!m_dirty)
-        return;
-    double width = -1;
+    QList<QTextLayout::FormatRange> ranges;
+    for (auto &format : block.formats) {
+        ranges.push_back(QTextLayout::FormatRange());
+        auto &range = ranges.last();
+        range.start = format.begin;
+        range.length = format.end - format.begin;
+        range.format = base;
+        for (auto it = format.style.begin(); it != format.style.end(); ++it)
+            range.format.setProperty(it.key(), it.value());
+        if (ruby) {
+            auto s = range.format.intProperty(QTextFormat::FontPixelSize);
+            const int px = s * 0.45 + 0.5;
+            range.format.setProperty(QTextFormat::FontPixelSize, px);
+        }
+    }
+    layout->setAdditionalFormats(ranges);
+}
+
+auto RichTextDocument::makeLayout(const RichTextBlock &blk, double maxWidth,
+                                  bool first) const -> QSharedPointer<const Layout>
+{
+    QSharedPointer<Layout> layout(new Layout);
+    auto &block = layout->block;
+    auto &rubies = layout->rubies;
+    block.setText(blk.text);
+    block.setTextOption(m_option);
+    setFormats(&block, blk, m_format, false);
+    rubies.resize(blk.rubies.size());
+    for (int j = 0; j < rubies.size(); ++j) {
+        rubies[j] = new QTextLayout;
+        rubies[j]->setText(blk.rubies[j].rt_block.text);
+        rubies[j]->setTextOption(rubyOption);
+        setFormats(rubies[j], blk.rubies[j].rt_block, m_format, true);
+    }
+
     const int px = m_format.intProperty(QTextFormat::FontPixelSize);
-    m_boxes.clear();
+    const bool empty = !blk.hasWords();
     QPointF pos(0, 0);
-    for (int i=0; i<m_layouts.size(); ++i) {
-        auto &block = m_layouts[i]->block;
-        auto &rubies = m_layouts[i]->rubies;
-
-        block.beginLayout();
-        int rt_idx = 0;
-        for (;;) {
-            QTextLine line = block.createLine();
-            if (!line.isValid())
+    block.beginLayout();
+    int rt_idx = 0;
+    for (;;) {
+        QTextLine line = block.createLine();
+        if (!line.isValid())
+            break;
+        line.setLineWidth(maxWidth);
+        line.setPosition(pos);
+        double rt_height = 0.0;
+        while (rt_idx < rubies.size()) {
+            const auto &ruby = blk.rubies[rt_idx];
+            if (!(line.textStart() <= ruby.rb_begin
+                  && ruby.rb_end <= line.textStart() + line.textLength()))
                 break;
-            line.setLineWidth(maxWidth);
-            line.setPosition(pos);
-            double rt_height = 0.0;
-            while (rt_idx < rubies.size()) {
-                const auto &ruby = m_blocks[i].rubies[rt_idx];
-                if (!(line.textStart() <= ruby.rb_begin
-                      && ruby.rb_end <= line.textStart() + line.textLength()))
-                    break;
-                const int left = line.cursorToX(ruby.rb_begin);
-                const int right = line.cursorToX(ruby.rb_end);
-                if (left < right) {
-                    QTextLayout *layout = rubies[rt_idx];
-                    layout->beginLayout();
-                    QTextLine line_rt = layout->createLine();
-                    if (line_rt.isValid()) {
-                        line_rt.setLineWidth(right - left);
-                        line_rt.setPosition(QPointF(left, pos.y()));
-                        if (rt_height < line_rt.height())
-                            rt_height = line_rt.height();
-                    }
-                    layout->endLayout();
+            const int left = line.cursorToX(ruby.rb_begin);
+            const int right = line.cursorToX(ruby.rb_end);
+            if (left < right) {
+                QTextLayout *layout = rubies[rt_idx];
+                layout->beginLayout();
+                QTextLine line_rt = layout->createLine();
+                if (line_rt.isValid()) {
+                    line_rt.setLineWidth(right - left);
+                    line_rt.setPosition(QPointF(left, pos.y()));
+                    if (rt_height < line_rt.height())
+                        rt_height = line_rt.height();
                 }
-                ++rt_idx;
+                layout->endLayout();
             }
-
-            const bool empty = !m_blocks[i].hasWords();
-            if (!empty) {
-                if (width < 0) {// first line
-                    pos.ry() += rt_height;
-                } else {
-                    const auto leading = m_blocks[i].paragraph
-                            ? m_paragraphLeading : m_lineLeading;
-                    pos.ry() += qMax(rt_height, leading * px);
-                }
-                line.setPosition(pos);
-                pos.ry() += line.height();
-                if (line.naturalTextWidth() > width)
-                    width = line.naturalTextWidth();
-                m_boxes << line.naturalTextRect();
-            } else if (width >= 0)
-                pos.ry() += px;
+            ++rt_idx;
         }
-        block.endLayout();
+
+        if (!empty) {
+            if (first) {// first line
+                pos.ry() += rt_height;
+            } else {
+                const auto leading = blk.paragraph
+                        ? m_paragraphLeading : m_lineLeading;
+                pos.ry() += qMax(rt_height, leading * px);
+            }
+            first = false;
+            line.setPosition(pos);
+            pos.ry() += line.height();
+            if (line.naturalTextWidth() > layout->width)
+                layout->width = line.naturalTextWidth();
+            layout->boxes << line.naturalTextRect();
+            layout->words = true;
+        } else if (!first)
+            pos.ry() += px;
     }
-    m_natural = QRectF(0.0, 0.0, width, pos.ry());
-    m_dirty = false;
+    block.endLayout();
+    layout->height = pos.y();
+    return layout;
 }
 
-auto RichTextDocument::updateLayoutInfo() -> void
+auto RichTextDocument::doLayout(double maxWidth) -> void
 {
-    if (m_blockChanged) {
-        freeLayouts();
-        m_layouts.resize(m_blocks.size());
-        m_formatChanged = m_optionChanged = true;
-        for (int i=0; i<m_blocks.size(); ++i) {
-            auto layout = m_layouts[i] = new Layout;
-            layout->block.setText(m_blocks[i].text);
-            layout->rubies.resize(m_blocks[i].rubies.size());
-            for (int j=0; j<layout->rubies.size(); ++j) {
-                layout->rubies[j] = new QTextLayout;
-                layout->rubies[j]->setText(m_blocks[i].rubies[j].rt_block.text);
-                layout->rubies[j]->setTextOption(rubyOption);
-            }
+    if (!m_dirty)
+        return;
+    auto &cache = RichTextLayoutCache::local();
+    RichTextLayoutCache::Key key;
+    key.format = m_format;
+    key.alignment = m_option.alignment();
+    key.wrap = m_option.wrapMode();
+    key.width = maxWidth;
+    key.line = m_lineLeading;
+    key.paragraph = m_paragraphLeading;
 
+    freeLayouts();
+    m_boxes.clear();
+    double width = -1, y = 0;
+    for (auto &block : m_blocks) {
+        key.block = block;
+        auto layout = cache.find(key);
+        if (!layout) {
+            layout = makeLayout(block, maxWidth, key.first);
+            cache.insert(key, layout);
         }
+        m_layouts.push_back(layout);
+        m_offsets.push_back(y);
+        for (auto &box : layout->boxes)
+            m_boxes.push_back(box.translated(0, y));
+        y += layout->height;
+        width = qMax(width, layout->width);
+        if (layout->words)
+            key.first = false;
     }
-    if (m_optionChanged) {
-        for (auto layout : m_layouts)
-            layout->block.setTextOption(m_option);
-    }
-    if (!m_formatChanged && m_pxChanged) {
-        auto adjustFormats = [this] (QTextLayout *layout,
-                                     const RichTextBlock &block, float r) {
-            auto ranges = layout->additionalFormats();
-            for (int j=0; j<ranges.size(); ++j) {
-                const auto &style = block.formats[j].style;
-                if (!style.contains(QTextFormat::FontPixelSize)) {
-                    const auto size
-                            = m_format.intProperty(QTextFormat::FontPixelSize);
-                    const int px = qRound(size * r);
-                    const auto ol = m_format.property(QTextFormat::TextOutline);
-                    ranges[j].format.setProperty(QTextFormat::FontPixelSize, px);
-                    ranges[j].format.setProperty(QTextFormat::TextOutline, ol);
-                }
-            }
-            layout->setAdditionalFormats(ranges);
-        };
-        for (int i=0; i<m_blocks.size(); ++i) {
-            const auto &block = m_blocks[i];
-            auto layout = m_layouts[i];
-            adjustFormats(&layout->block, block, 1);
-            for (int j = 0; j < block.rubies.size(); ++j)
-                adjustFormats(layout->rubies[j], block.rubies[j].rt_block, 0.45);
-        }
-    } else if (m_formatChanged) {
-        auto mergeFormat = [this] (QTextCharFormat &format,
-                                   const RichTextBlock::Style &style) {
-            format = m_format;
-            for (auto it = style.begin(); it != style.end(); ++it)
-                format.setProperty(it.key(), it.value());
-        };
-        auto setFormats = [mergeFormat] (QTextLayout *layout,
-                                         const RichTextBlock &blk, bool ruby) {
-            QList<QTextLayout::FormatRange> ranges;
-            for (auto &format : blk.formats) {
-                ranges.push_back(QTextLayout::FormatRange());
-                auto &range = ranges.last();
-                range.start = format.begin;
-                range.length = format.end - format.begin;
-                mergeFormat(range.format, format.style);
-                if (ruby) {
-                    auto s = range.format.intProperty(QTextFormat::FontPixelSize);
-                    const int px = s * 0.45 + 0.5;
-                    range.format.setProperty(QTextFormat::FontPixelSize, px);
-                }
-            }
-            layout->setAdditionalFormats(ranges);
-        };
-
-        for (int i=0; i<m_blocks.size(); ++i) {
-            const auto &block = m_blocks[i];
-            auto &layout = m_layouts[i];
-            setFormats(&layout->block, block, false);
-            for (int j = 0; j < block.rubies.size(); ++j)
-                setFormats(layout->rubies[j], block.rubies[j].rt_block, true);
-        }
-    }
+    m_natural = QRectF(0.0, 0.0, width, y);
+    m_dirty = false;
+}
+
+auto RichTextDocument::updateLayoutInfo() -> void
+{
+    // layouts are looked up or made in doLayout()
+    if (m_blockChanged || m_formatChanged || m_pxChanged || m_optionChanged)
+        m_dirty = true;
     m_blockChanged = m_formatChanged = m_pxChanged = m_optionChanged = false;
 }
 
 auto RichTextDocument::draw(QPainter *painter, const QPointF &pos) -> void
 {
-    for (auto layout : m_layouts) {
-        layout->block.draw(painter, pos);
-        for (auto ruby : layout->rubies)
-            ruby->draw(painter, pos);
+    for (int i = 0; i < m_layouts.size(); ++i) {
+        const QPointF at(pos.x(), pos.y() + m_offsets[i]);
+        m_layouts[i]->block.draw(painter, at);
+        for (auto ruby : m_layouts[i]->rubies)
+            ruby->draw(painter, at);
     }
 }
 
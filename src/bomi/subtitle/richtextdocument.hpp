@@ -52,10 +52,11 @@ public:
     auto clear() -> void { freeLayouts(); m_blocks.clear(); setChanged(true); }
     const QVector<QRectF> &boundingBoxes() const { return m_boxes; }
 private:
-    struct Layout {
-        QTextLayout block;
-        QVector<QTextLayout*> rubies;
-    };
+    // laid out block from its own origin, shared with others in same thread
+    struct Layout;
+    friend class RichTextLayoutCache;
+    auto makeLayout(const RichTextBlock &block, double maxWidth,
+                    bool first) const -> QSharedPointer<const Layout>;
     auto freeLayouts() -> void;
     inline auto setChanged(bool changed) -> void {
         m_dirty = m_blockChanged = m_formatChanged = m_pxChanged = m_optionChanged = changed;
@@ -66,7 +67,8 @@ private:
     QTextCharFormat m_format;
     double m_lineLeading = 0, m_paragraphLeading = 0;
 
-    QVector<Layout*> m_layouts;
+    QVector<QSharedPointer<const Layout>> m_layouts;
+    QVector<double> m_offsets;
     bool m_blockChanged, m_formatChanged, m_optionChanged, m_pxChanged, m_dirty;
     QRectF m_natural;
 };
@@ -2,6 +2,7 @@
 #include "subtitle_parser.hpp"
 #include "misc/log.hpp"
 #include "player/streamtrack.hpp"
+#include <numeric>
 
 DECLARE_LOG_CONTEXT(Subtitle)
 
@@ -10,6 +11,100 @@ auto SubComp::name() const -> QString
     return m_klass.isEmpty() ? m_file : m_file % "("_a % m_klass % ")"_a;
 }
 
+SubCompIndex::SubCompIndex(const Map &capts)
+    : m_capts(capts)
+{
+    // iterators point into the copy shared with SubComp until it detaches
+    m_keys.reserve(m_capts.size());
+    m_its.reserve(m_capts.size());
+    for (auto it = m_capts.cbegin(); it != m_capts.cend(); ++it) {
+        m_keys.push_back(it.key());
+        m_its.push_back(it);
+    }
+}
+
+template<class F>
+static auto forWords(const QString &text, F func) -> void
+{
+    const auto folded = text.normalized(QString::NormalizationForm_C).toCaseFolded();
+    int begin = -1;
+    for (int i = 0; i <= folded.size(); ++i) {
+        const bool word = i < folded.size()
+                && (folded[i].isLetterOrNumber() || folded[i].isMark());
+        if (word && begin < 0)
+            begin = i;
+        else if (!word && begin >= 0) {
+            func(folded.mid(begin, i - begin));
+            begin = -1;
+        }
+    }
+}
+
+auto SubCompIndex::tokenize() const -> void
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_tokenized)
+        return;
+    QHash<QString, QVector<int>> words;
+    for (int i = 0; i < m_its.size(); ++i) {
+        forWords(m_its[i]->toPlainText(), [&] (const QString &word) {
+            auto &positions = words[word];
+            if (positions.isEmpty() || positions.last() != i)
+                positions.push_back(i);
+        });
+    }
+    m_words.reserve(words.size());
+    m_positions.reserve(words.size());
+    for (auto it = words.begin(); it != words.end(); ++it) {
+        for (int i = 0; i < it.key().size(); ++i)
+            m_suffixes.push_back({ m_words.size(), i });
+        m_words.push_back(it.key());
+        m_positions.push_back(std::move(*it));
+    }
+    std::sort(m_suffixes.begin(), m_suffixes.end(),
+              [this] (const Suffix &lhs, const Suffix &rhs)
+                  { return suffix(lhs).compare(suffix(rhs)) < 0; });
+    m_tokenized = true;
+}
+
+auto SubCompIndex::search(const QString &text) const -> QVector<int>
+{
+    tokenize();
+    QStringList queries;
+    forWords(text, [&] (const QString &word) {
+        if (!queries.contains(word))
+            queries.push_back(word);
+    });
+    QVector<int> found;
+    if (queries.isEmpty()) {
+        found.resize(size());
+        std::iota(found.begin(), found.end(), 0);
+        return found;
+    }
+    // a query word may be a part of indexed word as text is matched anywhere
+    // hits[i] counts query words found in caption i so far
+    QVector<int> hits(size(), 0);
+    for (int q = 0; q < queries.size(); ++q) {
+        const auto &query = queries[q];
+        auto it = std::lower_bound(m_suffixes.cbegin(), m_suffixes.cend(), query,
+            [this] (const Suffix &s, const QString &query)
+                { return suffix(s).compare(query) < 0; });
+        for (; it != m_suffixes.cend() && suffix(*it).startsWith(query); ++it) {
+            for (auto i : m_positions[it->word]) {
+                if (hits[i] == q)
+                    hits[i] = q + 1;
+            }
+        }
+    }
+    for (int i = 0; i < hits.size(); ++i) {
+        if (hits[i] == queries.size())
+            found.push_back(i);
+    }
+    return found;
+}
+
+/******************************************************************************/
+
 auto Subtitle::component(double frameRate) const -> SubComp
 {
     if (m_comp.isEmpty())
@@ -22,6 +117,7 @@ auto Subtitle::component(double frameRate) const -> SubComp
 
 SubComp::SubComp() {
     m_capts[0].index = 0;
+    updateIndex();
 }
 
 SubComp::SubComp(SubType type, const QFileInfo &file, const EncodingInfo &enc, int id, SyncType b)
@@ -35,6 +131,30 @@ SubComp::SubComp(SubType type, const QFileInfo &file, const EncodingInfo &enc, i
     m_capts[0].index = 0;
 }
 
+auto SubComp::index() const -> SubCompIndexPtr
+{
+    // const SubComp can be shared by renderer and gui threads
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
+    if (!m_index)
+        m_index = SubCompIndexPtr(new SubCompIndex(m_capts));
+    return m_index;
+}
+
+auto SubComp::updateIndex() -> void
+{
+    m_index = SubCompIndexPtr(new SubCompIndex(m_capts));
+}
+
+auto SubComp::toKey(int time, double fps) const -> int
+{
+    if (time < 0)
+        return -1;
+    if (m_base == Frame)
+        return fps < 0.0 ? -1 : qRound(time*0.001*fps);
+    return time;
+}
+
 auto SubComp::toTrack() const -> StreamTrack
 {
     return StreamTrack::fromSubComp(*this);
@@ -47,22 +167,22 @@ auto SubComp::united(const SubComp &other, double frameRate) const -> SubComp
 
 auto SubComp::start(int time, double frameRate) const -> const_iterator
 {
-    if (isEmpty() || time < 0)
+    const int key = toKey(time, frameRate);
+    if (isEmpty() || key < 0)
         return end();
-    return --finish(time, frameRate);
+    const auto index = this->index();
+    const int i = index->find(key);
+    return i < 0 ? end() : index->iterator(i);
 }
 
 auto SubComp::finish(int time, double frameRate) const -> const_iterator
 {
-    if (isEmpty() || time < 0)
+    const int key = toKey(time, frameRate);
+    if (isEmpty() || key < 0)
         return end();
-    int key = time;
-    if (m_base == Frame) {
-        if (frameRate < 0.0)
-            return end();
-        key = qRound(time*0.001*frameRate);
-    }
-    return upperBound(key);
+    const auto index = this->index();
+    const int i = index->upperBound(key);
+    return i < index->size() ? index->iterator(i) : end();
 }
 
 auto SubComp::unite(const SubComp &rhs, double fps) -> SubComp&
@@ -115,6 +235,7 @@ auto SubComp::unite(const SubComp &rhs, double fps) -> SubComp&
     auto it = m_capts.begin();
     for (int idx = 0; it != m_capts.end(); ++idx, ++it)
         it->index = idx;
+    updateIndex();
     return *this;
 }
 
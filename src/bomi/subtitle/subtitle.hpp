@@ -27,6 +27,48 @@ struct SubCapt : public RichTextDocument {
     mutable int index;
 };
 
+// sorted array of caption start keys in SubComp for lookup by binary search
+// built once and shared read-only by renderers, models and viewers
+// it keeps a shallow copy of captions so that it can outlive its SubComp
+class SubCompIndex {
+public:
+    using Map = QMap<int, SubCapt>;
+    using ConstIt = Map::const_iterator;
+    SubCompIndex(const Map &capts);
+    auto size() const -> int { return m_keys.size(); }
+    auto isEmpty() const -> bool { return m_keys.isEmpty(); }
+    auto key(int i) const -> int { return m_keys[i]; }
+    auto iterator(int i) const -> ConstIt { return m_its[i]; }
+    auto caption(int i) const -> const SubCapt& { return *m_its[i]; }
+    // position of last caption starting at or before key, -1 if none
+    auto find(int key) const -> int { return upperBound(key) - 1; }
+    // position of first caption starting after key, size() if none
+    auto upperBound(int key) const -> int
+        { return std::upper_bound(m_keys.begin(), m_keys.end(), key) - m_keys.begin(); }
+    // ascending positions of captions which may contain text, ignoring case
+    // candidates should be checked again for exact match
+    auto search(const QString &text) const -> QVector<int>;
+    // words are indexed on first search unless done here in advance
+    auto tokenize() const -> void;
+private:
+    // part of a word from offset to its end
+    struct Suffix { int word, offset; };
+    auto suffix(const Suffix &s) const -> QStringRef
+        { return m_words[s.word].midRef(s.offset); }
+    const Map m_capts;
+    QVector<int> m_keys;
+    QVector<ConstIt> m_its;
+    // case-folded words and ascending positions of captions with each
+    mutable QStringList m_words;
+    mutable QVector<QVector<int>> m_positions;
+    // suffixes of all words sorted by text, where substring is a prefix
+    mutable QVector<Suffix> m_suffixes;
+    mutable bool m_tokenized = false;
+    mutable QMutex m_mutex;
+};
+
+using SubCompIndexPtr = QSharedPointer<const SubCompIndex>;
+
 class SubComp {
 public:
     using Map = QMap<int, SubCapt>;
@@ -39,7 +81,7 @@ public:
     auto operator == (const SubComp &rhs) const -> bool
         {return m_path == rhs.m_path && m_klass == rhs.m_klass;}
     auto operator != (const SubComp &rhs) const -> bool {return !operator==(rhs);}
-    auto operator[] (int key) -> SubCapt& { return m_capts[key]; }
+    auto operator[] (int key) -> SubCapt& { m_index.reset(); return m_capts[key]; }
     auto operator[] (int key) const -> SubCapt { return m_capts[key]; }
     auto unite(const SubComp &other, double frameRate) -> SubComp&;
     auto united(const SubComp &other, double frameRate) const -> SubComp;
@@ -47,17 +89,18 @@ public:
     auto hasWords() const -> bool
         { for (auto &c : m_capts) if (c.hasWords()) return true; return false; }
     auto isEmpty() const -> bool { return m_capts.isEmpty(); }
-    auto begin() -> It { return m_capts.begin(); }
-    auto end() -> It { return m_capts.end(); }
+    auto begin() -> It { m_index.reset(); return m_capts.begin(); }
+    auto end() -> It { m_index.reset(); return m_capts.end(); }
     auto begin() const -> ConstIt { return m_capts.begin(); }
     auto end() const -> ConstIt { return m_capts.end(); }
     auto cbegin() const -> ConstIt { return m_capts.cbegin(); }
     auto cend() const -> ConstIt { return m_capts.cend(); }
-    auto upperBound(int key) -> It { return m_capts.upperBound(key); }
-    auto lowerBound(int key) -> It { return m_capts.lowerBound(key); }
+    auto upperBound(int key) -> It { m_index.reset(); return m_capts.upperBound(key); }
+    auto lowerBound(int key) -> It { m_index.reset(); return m_capts.lowerBound(key); }
     auto upperBound(int key) const -> ConstIt { return m_capts.upperBound(key); }
     auto lowerBound(int key) const -> ConstIt { return m_capts.lowerBound(key); }
-    auto insert(int key, const SubCapt &capt) -> It { return m_capts.insert(key, capt); }
+    auto insert(int key, const SubCapt &capt) -> It
+        { m_index.reset(); return m_capts.insert(key, capt); }
     auto contains(int key) const -> bool { return m_capts.contains(key); }
     auto name() const -> QString;
     auto fileName() const -> const QString& {return m_file;}
@@ -69,6 +112,11 @@ public:
     auto start(int time, double frameRate) const -> const_iterator;
     auto finish(int time, double frameRate) const -> const_iterator;
     auto toTime(int key, double fps) const -> int { return m_base == Time ? key : msec(key, fps); }
+    // key for time, -1 if not available
+    auto toKey(int time, double fps) const -> int;
+    // index is made on demand and cached if modified after updateIndex()
+    auto index() const -> SubCompIndexPtr;
+    auto updateIndex() -> void;
     auto map() const -> const Map& { return m_capts; }
     auto setLanguage(const QString &lang) -> void { m_klass = lang; }
     auto selection() const -> bool { return m_selection; }
@@ -86,6 +134,7 @@ private:
     EncodingInfo m_enc;
     SyncType m_base = Time;
     Map m_capts;
+    mutable SubCompIndexPtr m_index; // reset whenever m_capts may be modified
     bool m_selection = false;
     int m_id = -1;
     SubType m_type = SubType::Unknown;
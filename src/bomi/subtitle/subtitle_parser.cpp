@@ -1,6 +1,6 @@
 #include "subtitle_parser_p.hpp"
 #include "misc/log.hpp"
-#include <QTextStream>
+#include <QTextCodec>
 
 DECLARE_LOG_CONTEXT(Subtitle)
 
@@ -13,16 +13,66 @@ auto SubtitleParser::append(Subtitle &s, SubComp::SyncType b) -> SubComp&
     return s.m_comp.last();
 }
 
+// bytes used to find out the format before decoding whole file
+static constexpr const int SniffSize = 16 * 1024;
+static constexpr const int DecodeChunk = 256 * 1024;
+static constexpr const qint64 MaxFileSize = 64 * 1024 * 1024;
+
+static auto decode(const uchar *data, qint64 size, QTextCodec *codec) -> QString
+{
+    QString text;
+    text.reserve(size);
+    QScopedPointer<QTextDecoder> decoder(codec->makeDecoder());
+    for (qint64 pos = 0; pos < size; pos += DecodeChunk) {
+        const int len = qMin<qint64>(DecodeChunk, size - pos);
+        text += decoder->toUnicode(reinterpret_cast<const char*>(data + pos), len);
+    }
+    text.squeeze();
+    return text;
+}
+
+// BOM wins over given encoding, which falls back to locale as QTextStream did
+static auto codecFor(const QByteArray &head, const EncodingInfo &enc) -> QTextCodec*
+{
+    auto codec = enc.codec();
+    return QTextCodec::codecForUtfText(head, codec ? codec : QTextCodec::codecForLocale());
+}
+
+static auto parsers() -> QVector<SubtitleParser*>
+{
+    return { new SamiParser, new SubRipParser,
+             new MicroDVDParser, new TMPlayerParser };
+}
+
+auto SubtitleParser::sniff(const QString &head) -> SubtitleParser*
+{
+    SubtitleParser *found = nullptr;
+    for (auto p : parsers()) {
+        p->m_all = head;
+        if (!found && p->isParsable())
+            found = p;
+        else
+            delete p;
+    }
+    return found;
+}
+
 auto SubtitleParser::parse(const QString &fileName,
                            const EncodingInfo &enc) -> Subtitle
 {
     QFile file(fileName);
-    if (!file.open(QFile::ReadOnly) || file.size() > (1 << 20))
+    if (!file.open(QFile::ReadOnly) || file.size() > MaxFileSize)
         return Subtitle();
-    QTextStream in;
-    in.setDevice(&file);
-    in.setCodec(enc.codec());
-    const QString all = in.readAll();
+    QByteArray buffer;
+    const qint64 size = file.size();
+    const uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (!data) {
+        buffer = file.readAll();
+        data = reinterpret_cast<const uchar*>(buffer.constData());
+    }
+    const int headSize = qMin<qint64>(SniffSize, size);
+    auto codec = codecFor(QByteArray::fromRawData(
+        reinterpret_cast<const char*>(data), headSize), enc);
     QFileInfo info(fileName);
     Subtitle sub;
 
@@ -40,23 +90,46 @@ auto SubtitleParser::parse(const QString &fileName,
             return u"Unknown"_q;
         }
     };
+    // find the format from the head of file so that only one parser scans it
+    const auto head = decode(data, headSize, codec);
+    auto found = sniff(head);
+
+    const auto all = headSize < size ? decode(data, size, codec) : head;
+    file.close();
+    buffer.clear();
+
     auto tryIt = [&] (SubtitleParser *p) {
         p->m_all = all;
+        p->m_pos = 0;
         p->m_file = info;
         p->m_encoding = enc;
         const bool parsable = p->isParsable();
         _Info("Trying (parser: %%, encoding: %%, file: %%): %%",
-               name(p->type()), enc.name(), file.fileName(), parsable);
+               name(p->type()), enc.name(), fileName, parsable);
         if (parsable)
             p->_parse(sub);
         delete p;
         return parsable;
     };
 
-    if (tryIt(new SamiParser) || tryIt(new SubRipParser)
-            || tryIt(new MicroDVDParser) || tryIt(new TMPlayerParser))
-        return sub;
-    return Subtitle();
+    // head may look different when the file starts with a long preamble,
+    // so others are tried if sniffed one fails for whole file
+    const auto sniffed = found ? found->type() : SubType::Unknown;
+    bool ok = found && tryIt(found);
+    for (auto p : parsers()) {
+        if (ok || p->type() == sniffed)
+            delete p;
+        else
+            ok = tryIt(p);
+    }
+    if (!ok)
+        return Subtitle();
+    // parsing runs in background, so index words here before searched
+    for (auto &comp : sub.m_comp) {
+        comp.updateIndex();
+        comp.index()->tokenize();
+    }
+    return sub;
 }
 
 auto SubtitleParser::processLine(int &idx, const QString &texts) -> QStringRef
@@ -36,7 +36,11 @@ protected:
         { c[start] += RichTextDocument(text); }
     static auto append(SubComp &c, const QString &t, int start, int end) -> void
         { append(c, t, start); c[end]; }
+    static auto append(SubComp &c, const QList<RichTextBlock> &blocks,
+                       int start, int end) -> void
+        { c[start] += blocks; c[end]; }
 private:
+    static auto sniff(const QString &head) -> SubtitleParser*;
     static int msPerChar;
     QString m_all;
     EncodingInfo m_encoding;
@@ -68,33 +68,158 @@ auto SubRipParser::isParsable() const -> bool
     return all().contains(rx);
 }
 
+SIA _IsDigit(ushort c) -> bool { return '0' <= c && c <= '9'; }
+
+// hh:mm:ss,mmm where '.' is also accepted for ',' and ms may be shorter
+static auto _ParseSrtTime(const QStringRef &text, int &pos, int &ms) -> bool
+{
+    int fields[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < 4; ++i) {
+        if (i > 0) {
+            if (pos >= text.size())
+                return false;
+            const ushort sep = text.at(pos).unicode();
+            if (i < 3 ? sep != ':' : !_IsOneOf(sep, ',', '.'))
+                return false;
+            ++pos;
+        }
+        int digits = 0;
+        for (; pos < text.size() && _IsDigit(text.at(pos).unicode()); ++digits)
+            fields[i] = fields[i] * 10 + text.at(pos++).unicode() - '0';
+        if (!digits || (i == 3 && digits > 3))
+            return false;
+        if (i == 3)
+            for (; digits < 3; ++digits)
+                fields[i] *= 10;
+    }
+    ms = _TimeToMSec(fields[0], fields[1], fields[2], fields[3]);
+    return true;
+}
+
+auto SubRipParser::parseTiming(const QStringRef &line, int &start, int &end) -> bool
+{
+    int pos = 0;
+    skipSeparator(pos, line);
+    if (!_ParseSrtTime(line, pos, start))
+        return false;
+    skipSeparator(pos, line);
+    if (line.mid(pos, 3) != "-->"_a)
+        return false;
+    pos += 3;
+    skipSeparator(pos, line);
+    return _ParseSrtTime(line, pos, end);
+}
+
+// builds a block in the same way as RichTextBlockParser does for plain text:
+// runs of separators become a space and leading/trailing ones are dropped
+static auto _PlainBlock(const QStringRef &line, bool paragraph) -> RichTextBlock
+{
+    RichTextBlock block(paragraph);
+    block.text.reserve(line.size());
+    bool sep = false;
+    for (int i = 0; i < line.size(); ++i) {
+        const ushort c = line.at(i).unicode();
+        if (RichTextHelper::isSeparator(c)) {
+            sep = true;
+            continue;
+        }
+        if (sep && !block.text.isEmpty())
+            block.text += ' '_q;
+        sep = false;
+        if (c == '\\' && i + 1 < line.size() && line.at(i + 1) == 'h'_q) {
+            block.text += QChar(0xa0);
+            ++i;
+        } else
+            block.text += QChar(c);
+    }
+    RichTextBlock::Format format;
+    format.begin = 0;
+    format.end = block.text.size();
+    block.formats.append(format);
+    return block;
+}
+
 auto SubRipParser::_parse(Subtitle &sub) -> void
 {
     sub.clear();
     auto &comp = append(sub);
-    const auto &all = this->all();
-    auto prev = rx.match(all);
-    if (!prev.hasMatch())
-        return;
+    struct Cue { int start = -1, end = -1; QVector<QStringRef> lines; } cue;
 
-    for(;;) {
-        const auto m = rx.match(all, prev.capturedEnd());
-        const int begin = prev.capturedEnd();
-        const int end = m.hasMatch() ? m.capturedStart() : all.size();
-        auto caption = all.midRef(begin, end - begin).trimmed().toString();
-        caption.replace(QRegEx(uR"((\r\n|\n|\r|\\N))"_q), u"<br>"_q);
-        caption.replace("\\h"_a, u"&nbsp;"_q);
-        if (caption.isEmpty())
-            caption = u"<br>"_q;
-#define TO_INT(n) (prev.capturedRef(n).toInt())
-        const int t1 = _TimeToMSec(TO_INT(3), TO_INT(4), TO_INT(5), TO_INT(6));
-        const int t2 = _TimeToMSec(TO_INT(7), TO_INT(8), TO_INT(9), TO_INT(10));
-#undef TO_INT
-        append(comp, "<p>"_a % caption % "</p>"_a, t1, t2);
-        if (!m.hasMatch())
-            break;
-        prev = m;
+    auto flush = [&] () {
+        if (cue.start < 0)
+            return;
+        auto &lines = cue.lines;
+        // split \N and drop blank lines around caption
+        for (int i = 0; i < lines.size(); ++i) {
+            const int idx = lines[i].indexOf("\\N"_a);
+            if (idx >= 0) {
+                lines.insert(i + 1, lines[i].mid(idx + 2));
+                lines[i] = lines[i].left(idx);
+            }
+        }
+        while (!lines.isEmpty() && trim(lines.last()).isEmpty())
+            lines.removeLast();
+        while (!lines.isEmpty() && trim(lines.first()).isEmpty())
+            lines.removeFirst();
+        bool markup = false;
+        for (auto &line : lines)
+            markup = markup || line.contains('<'_q) || line.contains('&'_q);
+        if (markup) { // rare enough to leave to RichTextBlockParser
+            QString caption;
+            for (int i = 0; i < lines.size(); ++i) {
+                if (i > 0)
+                    caption += "<br>"_a;
+                caption += replace(trim(lines[i]), u"\\h"_q, u"&nbsp;"_q,
+                                   Qt::CaseSensitive);
+            }
+            append(comp, "<p>"_a % caption % "</p>"_a, cue.start, cue.end);
+        } else {
+            QList<RichTextBlock> blocks;
+            for (int i = 0; i < lines.size(); ++i)
+                blocks.append(_PlainBlock(lines[i], i == 0));
+            if (blocks.isEmpty()) // same as "<p><br></p>"
+                blocks << _PlainBlock(QStringRef(), true)
+                       << _PlainBlock(QStringRef(), false);
+            append(comp, blocks, cue.start, cue.end);
+        }
+    };
+
+    auto isIndex = [] (const QStringRef &line) {
+        const auto number = trim(line);
+        for (auto c : number) {
+            if (!_IsDigit(c.unicode()))
+                return false;
+        }
+        return !number.isEmpty();
+    };
+
+    // blank lines may come between index and timing as old regex allowed:
+    // "1\n\n00:00:01,000 --> 00:00:02,000\ntext" has a cue from 1s to 2s
+    auto timing = [&] (int &start, int &end) {
+        const int pos = this->pos();
+        auto next = getLine();
+        while (!next.isNull() && trim(next).isEmpty())
+            next = getLine();
+        if (parseTiming(next, start, end))
+            return true;
+        seekTo(pos);
+        return false;
+    };
+
+    seekTo(0);
+    auto line = getLine();
+    while (!line.isNull()) {
+        int start = 0, end = 0;
+        if (isIndex(line) && timing(start, end)) {
+            flush();
+            cue.start = start;
+            cue.end = end;
+            cue.lines.clear();
+        } else if (cue.start >= 0)
+            cue.lines.push_back(line);
+        line = getLine();
     }
+    flush();
 }
 
 /******************************************************************************/
@@ -22,6 +22,7 @@ public:
     auto isParsable() const -> bool;
     auto type() const -> SubType { return SubType::SubRip; }
 private:
+    static auto parseTiming(const QStringRef &line, int &start, int &end) -> bool;
     QRegEx rx;
 };
 
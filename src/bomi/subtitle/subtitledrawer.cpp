@@ -18,6 +18,99 @@ SubCompImage::SubCompImage(const SubComp *comp)
 
 /******************************************************************************/
 
+auto AlphaTint::setColor(const QColor &color) -> void
+{
+    const auto rgba = color.rgba();
+    if (!_Change(m_rgba, rgba))
+        return;
+    const quint32 r = qRed(rgba), g = qGreen(rgba), b = qBlue(rgba);
+    const quint32 a = qAlpha(rgba);
+    for (quint32 i = 0; i < 256; ++i) {
+        const quint32 alpha = a * i;
+        auto mul = [alpha] (quint32 c) { return (c * alpha + 32512) / 65025; };
+        m_lut[i] = (mul(255) << 24) | (mul(r) << 16) | (mul(g) << 8) | mul(b);
+    }
+}
+
+/******************************************************************************/
+
+auto FastAlphaBlur::setRadius(int radius) -> void
+{
+    if (_Change(m_radius, radius)) {
+        const int range = (radius << 1) + 1;
+        m_inv.resize(range << 8);
+        for (int i = 0; i < m_inv.size(); ++i)
+            m_inv[i] = i/range;
+    }
+}
+
+// box blur each row of src (w x h) and store it as a column of dst (h x w).
+// rows are processed in blocks so that writes to dst are contiguous.
+auto FastAlphaBlur::blur(const uchar *src, uchar *dst, int w, int h) -> void
+{
+    static constexpr int Block = 16;
+    const int r = m_radius, last = w - 1;
+    const uchar *inv = m_inv.constData();
+    int sums[Block];
+    for (int y0 = 0; y0 < h; y0 += Block) {
+        const int rows = qMin(Block, h - y0);
+        const uchar *in = src + y0 * w;
+        for (int j = 0; j < rows; ++j) {
+            const uchar *line = in + j * w;
+            int sum = 0;
+            for (int i = -r; i <= r; ++i)
+                sum += line[qBound(0, i, last)];
+            sums[j] = sum;
+        }
+        uchar *out = dst + y0;
+        for (int x = 0; x < w; ++x, out += h) {
+            const int add = qMin(x + r + 1, last), sub = qMax(x - r, 0);
+            for (int j = 0; j < rows; ++j) {
+                const uchar *line = in + j * w;
+                out[j] = inv[sums[j]];
+                sums[j] += line[add] - line[sub];
+            }
+        }
+    }
+}
+
+auto FastAlphaBlur::applyTo(QImage &mask, const QColor &color,
+                            int radius, int passes) -> void
+{
+    if (radius < 1 || passes < 1 || mask.isNull())
+        return;
+    // keep variance of single box blur with given radius
+    const int range = (radius << 1) + 1;
+    const double r = (qSqrt((range * range - 1.0) / passes + 1.0) - 1.0) * 0.5;
+    setRadius(qMax(1, qRound(r)));
+
+    const int w = mask.width(), h = mask.height();
+    m_plane.resize(w * h);
+    m_transposed.resize(w * h);
+    uchar *a = m_plane.data();
+    for (int y = 0; y < h; ++y, a += w) {
+        auto line = reinterpret_cast<const quint32*>(mask.constScanLine(y));
+        for (int x = 0; x < w; ++x)
+            a[x] = line[x] >> 24;
+    }
+    for (int i = 0; i < passes; ++i) {
+        blur(m_plane.constData(), m_transposed.data(), w, h);
+        blur(m_transposed.constData(), m_plane.data(), h, w);
+    }
+
+    m_tint.setColor(QColor(color.red(), color.green(), color.blue()));
+    const uchar *c_a = m_plane.constData();
+    for (int y = 0; y < h; ++y, c_a += w) {
+        auto line = reinterpret_cast<quint32*>(mask.scanLine(y));
+        for (int x = 0; x < w; ++x) {
+            if ((line[x] >> 24) < 255)
+                line[x] = m_tint[c_a[x]];
+        }
+    }
+}
+
+/******************************************************************************/
+
 auto SubtitleDrawer::pos(const QSizeF &img, const QRectF &area) const -> QPointF
 {
     QPointF pos(0.0, 0.0);
@@ -42,6 +135,33 @@ auto SubtitleDrawer::pos(const QSizeF &img, const QRectF &area) const -> QPointF
     return pos;
 }
 
+auto SubtitleDrawer::composeBoxes(QImage &image,
+                                  const QVector<QRectF> &boxes) const -> void
+{
+    if (boxes.isEmpty() || image.isNull())
+        return;
+    QImage bg(image.size(), QImage::Format_ARGB32_Premultiplied);
+    bg.fill(0x0);
+    QPainter painter(&bg);
+    auto bcolor = m_style.bbox.color;
+    bcolor.setAlpha(255);
+    for (auto &bbox : boxes)
+        painter.fillRect(bbox, bcolor);
+    const auto alpha = m_style.bbox.color.alphaF();
+    auto p = bg.bits();
+    for (int i=0; i<bg.width(); ++i) {
+        for (int j=0; j<bg.height(); ++j) {
+            *p++ *= alpha;
+            *p++ *= alpha;
+            *p++ *= alpha;
+            *p++ *= alpha;
+        }
+    }
+    painter.drawImage(QPoint(0, 0), image);
+    painter.end();
+    image.swap(bg);
+}
+
 auto SubtitleDrawer::setStyle(const OsdStyle &style) -> void
 {
     m_style = style;
@@ -108,43 +228,32 @@ auto SubtitleDrawer::draw(QImage &image, int &gap, const RichTextDocument &text,
         front.draw(&painter, QPointF(0, 0));
         painter.end();
         if (m_style.shadow.enabled) {
-            QImage bg(image.size(), QImage::Format_ARGB32_Premultiplied);
+            // shadow layer lives in a buffer reused for later captions
+            const int w = image.width(), h = image.height(), bpl = w * 4;
+            if (m_buffer.size() < bpl * h)
+                m_buffer.resize(bpl * h);
+            QImage bg(reinterpret_cast<uchar*>(m_buffer.data()), w, h, bpl,
+                      QImage::Format_ARGB32_Premultiplied);
             bg.setDevicePixelRatio(dpr);
-            auto dest = bg.bits();
-            const quint32 sr = m_style.shadow.color.red();
-            const quint32 sg = m_style.shadow.color.green();
-            const quint32 sb = m_style.shadow.color.blue();
-            const quint32 sa = m_style.shadow.color.alpha();
-            for (int y=0; y<bg.height(); ++y) {
+            m_tint.setColor(m_style.shadow.color);
+            const int sx = qMin(soffset.x(), w);
+            for (int y = 0; y < h; ++y) {
+                auto dest = reinterpret_cast<quint32*>(bg.scanLine(y));
                 const int ys = y - soffset.y();
                 if (ys < 0) {
-                    memset(dest, 0, bg.bytesPerLine());
-                    dest += bg.bytesPerLine();
+                    memset(dest, 0, bpl);
                 } else {
-                    auto src = image.bits() + image.bytesPerLine() * ys;
-                    for (int x=0; x<bg.width(); ++x) {
-                        const int xs = x-soffset.x();
-                        if (xs < 0) {
-                            *dest++ = 0;
-                            *dest++ = 0;
-                            *dest++ = 0;
-                            *dest++ = 0;
-                        } else {
-                            *dest++ = sb*sa*src[3] >> 16;
-                            *dest++ = sg*sa*src[3] >> 16;
-                            *dest++ = sr*sa*src[3] >> 16;
-                            *dest++ = sa*   src[3] >> 8;
-                            src += 4;
-                        }
-                    }
+                    memset(dest, 0, sx * 4);
+                    auto src = reinterpret_cast<const quint32*>(image.constScanLine(ys));
+                    m_tint.apply(src, dest + sx, w - sx);
                 }
             }
             if (blur)
                 m_blur.applyTo(bg, m_style.shadow.color, blur);
-            painter.begin(&bg);
-            painter.drawImage(QPoint(0, 0), image);
+            painter.begin(&image);
+            painter.setCompositionMode(QPainter::CompositionMode_DestinationOver);
+            painter.drawImage(QPoint(0, 0), bg);
             painter.end();
-            image.swap(bg);
         }
         if (m_style.bbox.enabled) {
             bboxes = front.boundingBoxes();
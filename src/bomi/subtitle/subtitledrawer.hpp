@@ -11,101 +11,34 @@ struct Margin {
     double top = 0.0, right = 0.0, bottom = 0.0, left = 0.0;
 };
 
-class FastAlphaBlur {
+// Premultiplied color for each alpha value, to fill pixels with a color
+// using alpha channel of other image as mask
+class AlphaTint {
 public:
-    FastAlphaBlur(): radius(-1) {}
-    // copied from openframeworks superfast blur and modified
-    auto applyTo(QImage &mask, const QColor &color, int radius) -> void {
-        if (radius < 1 || mask.isNull())
-            return;
-        setSize(mask.size());
-        setRadius(radius);
-        const int w = s.width();
-        const int h = s.height();
-
-        uchar *a = valpha.data();
-        const uchar *inv = vinv.constData();
-        int *min = vmin.data();
-        int *max = vmax.data();
-
-        const int xmax = mask.width()-1;
-        for (int x=0; x<w; ++x) {
-            min[x] = qMin(x + radius + 1, xmax);
-            max[x] = qMax(x - radius, 0);
-        }
-
-        const uchar *c_bits = mask.constBits()+3;
-        uchar *it = a;
-        for (int y=0; y<h; ++y, c_bits += (mask.width() << 2)) {
-            int sum = 0;
-            for(int i=-radius; i<=radius; ++i)
-                sum += c_bits[qBound(0, i, xmax) << 2];
-            for (int x=0; x<w; ++x, ++it) {
-                sum += c_bits[min[x] << 2];
-                sum -= c_bits[max[x] << 2];
-                *it = inv[sum];
-            }
-        }
-
-        const int ymax = mask.height()-1;
-        for (int y=0; y<h; ++y){
-            min[y] = qMin(y + radius + 1, ymax)*w;
-            max[y] = qMax(y - radius, 0)*w;
-        }
-
-        uchar *bits = mask.bits();
-        const double r = color.redF();
-        const double g = color.greenF();
-        const double b = color.blueF();
-        const uchar *c_it = a;
-        for (int x=0; x<w; ++x, ++c_it){
-            int sum = 0;
-            int yp = -radius*w;
-            for(int i=-radius; i<=radius; ++i, yp += w)
-                sum += c_it[qMax(0, yp)];
-            uchar *p = bits + (x << 2);
-            for (int y=0; y<h; ++y, p += (xmax << 2)){
-                const uchar a = inv[sum];
-                if (p[3] < 255) {
-                    *p++ = a*b;
-                    *p++ = a*g;
-                    *p++ = a*r;
-                    *p++ = a;
-                } else {
-                    p += 4;
-                }
-                sum += c_it[min[y]];
-                sum -= c_it[max[y]];
-            }
-        }
-    }
+    auto setColor(const QColor &color) -> void;
+    auto operator [] (int alpha) const -> quint32 { return m_lut[alpha]; }
+    // dst[i] = color * alpha(src[i])
+    auto apply(const quint32 *src, quint32 *dst, int count) const -> void
+        { for (int i = 0; i < count; ++i) dst[i] = m_lut[src[i] >> 24]; }
+private:
+    QRgb m_rgba = 0;
+    std::array<quint32, 256> m_lut{};
+};
 
+// Blurs alpha channel of an image and fills it with a color.
+// Successive box blurs approximate gaussian blur. Each pass blurs rows and
+// writes them transposed so that columns are also read in sequence.
+// Buffers are kept for later calls.
+class FastAlphaBlur {
+public:
+    auto applyTo(QImage &mask, const QColor &color, int radius,
+                 int passes = 3) -> void;
 private:
-    auto setSize(const QSize &size) -> void {
-        if (size != s) {
-            s = size;
-            if (!s.isEmpty()) {
-                vmin.resize(qMax(s.width(), s.height()));
-                vmax.resize(vmin.size());
-                valpha.resize(s.width()*s.height());
-            }
-        }
-    }
-    auto setRadius(const int radius) -> void {
-        if (this->radius != radius) {
-            this->radius = radius;
-            if (radius > 0) {
-                const int range = (radius << 1) + 1;
-                vinv.resize(range << 8);
-                for (int i=0; i<vinv.size(); ++i)
-                    vinv[i] = i/range;
-            }
-        }
-    }
-    int radius;
-    QSize s;
-    QVector<int> vmin, vmax;
-    QVector<uchar> valpha, vinv;
+    auto setRadius(int radius) -> void;
+    auto blur(const uchar *src, uchar *dst, int w, int h) -> void;
+    int m_radius = -1;
+    QVector<uchar> m_plane, m_transposed, m_inv;
+    AlphaTint m_tint;
 };
 
 class SubCompImage : public QImage {
@@ -141,6 +74,8 @@ public:
               const QRectF &area, double dpr = 1.0) -> QVector<QRectF>;
     auto draw(SubCompImage &pic, const QRectF &area, double dpr = 1.0) -> bool;
     auto pos(const QSizeF &image, const QRectF &area) const -> QPointF;
+    // put boxes returned by draw() behind image in one image
+    auto composeBoxes(QImage &image, const QVector<QRectF> &boxes) const -> void;
     auto alignment() const -> Qt::Alignment { return m_alignment; }
     auto margin() const -> const Margin& { return m_margin; }
     auto style() const -> const OsdStyle& {return m_style;}
@@ -154,7 +89,8 @@ private:
     Qt::Alignment m_alignment;
     bool m_drawn = false;
     FastAlphaBlur m_blur;
-    QByteArray m_buffer;
+    AlphaTint m_tint;
+    QByteArray m_buffer; // for shadow layer
 };
 
 inline auto SubtitleDrawer::setAlignment(Qt::Alignment alignment) -> void
@@ -0,0 +1,107 @@
+#include "subtitleloader.hpp"
+#include "misc/dataevent.hpp"
+#include <QThreadPool>
+#include <QRunnable>
+
+static constexpr const int BatchFinished = QEvent::User + 1;
+
+struct SubtitleLoader::Batch {
+    QVector<Task> tasks;
+    QVector<Result> results;
+    std::atomic<int> remaining{0};
+    quint64 generation = 0;
+    const std::atomic<quint64> *current = nullptr;
+    Callback callback;
+    auto isCancelled() const -> bool { return generation != current->load(); }
+};
+
+class SubtitleLoader::Job : public QRunnable {
+public:
+    Job(const BatchPtr &batch, int index, QObject *receiver)
+        : m_batch(batch), m_index(index), m_receiver(receiver) { }
+private:
+    auto run() -> void final
+    {
+        if (!m_batch->isCancelled())
+            m_batch->results[m_index] = SubtitleLoader::run(m_batch->tasks[m_index]);
+        if (m_batch->remaining.fetch_sub(1) == 1)
+            _PostEvent(m_receiver, BatchFinished, m_batch);
+    }
+    BatchPtr m_batch;
+    const int m_index;
+    QObject *m_receiver = nullptr;
+};
+
+struct SubtitleLoader::Data {
+    QThreadPool pool;
+    std::atomic<quint64> generation{0};
+    int running = 0;
+};
+
+SubtitleLoader::SubtitleLoader(QObject *parent)
+    : QObject(parent), d(new Data)
+{
+    // parsing is mostly bound by memory, not cpu
+    d->pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), 4));
+    d->pool.setExpiryTimeout(10000);
+}
+
+SubtitleLoader::~SubtitleLoader()
+{
+    cancel();
+    d->pool.waitForDone();
+    delete d;
+}
+
+auto SubtitleLoader::load(const QVector<Task> &tasks, Callback &&cb) -> void
+{
+    BatchPtr batch(new Batch);
+    batch->tasks = tasks;
+    batch->results.resize(tasks.size());
+    batch->generation = d->generation.load();
+    batch->current = &d->generation;
+    batch->callback = std::move(cb);
+    batch->remaining = tasks.size();
+    ++d->running;
+    if (tasks.isEmpty())
+        _PostEvent(this, BatchFinished, batch);
+    for (int i = 0; i < tasks.size(); ++i)
+        d->pool.start(new Job(batch, i, this));
+}
+
+auto SubtitleLoader::run(const Task &task) -> Result
+{
+    Result result;
+    result.file = task.file;
+    result.encoding = task.encoding;
+    if (task.detect) {
+        const auto &fb = task.encoding;
+        result.encoding = fb.isValid()
+            ? EncodingInfo::detect(EncodingInfo::Subtitle, fb, task.file)
+            : EncodingInfo::detect(EncodingInfo::Subtitle, task.file);
+    }
+    result.subtitle.load(task.file, result.encoding);
+    return result;
+}
+
+auto SubtitleLoader::cancel() -> void
+{
+    // queued jobs of stale batches skip parsing but still report back
+    ++d->generation;
+}
+
+auto SubtitleLoader::isLoading() const -> bool
+{
+    return d->running > 0;
+}
+
+auto SubtitleLoader::customEvent(QEvent *event) -> void
+{
+    if (event->type() != BatchFinished)
+        return;
+    BatchPtr batch;
+    _TakeData(event, batch);
+    --d->running;
+    if (!batch->isCancelled() && batch->callback)
+        batch->callback(batch->results);
+}
@@ -0,0 +1,39 @@
+#ifndef SUBTITLELOADER_HPP
+#define SUBTITLELOADER_HPP
+
+#include "subtitle.hpp"
+#include "misc/encodinginfo.hpp"
+
+// Parses subtitle files in worker threads and delivers them in the thread
+// where the loader lives. Callbacks of cancelled batches are never called.
+class SubtitleLoader : public QObject {
+public:
+    struct Task {
+        QString file;
+        EncodingInfo encoding;
+        bool detect = false; // detect encoding, falling back to given one
+    };
+    struct Result {
+        QString file;
+        EncodingInfo encoding; // encoding actually used
+        Subtitle subtitle;     // empty if bomi cannot parse the file
+        auto isParsed() const -> bool { return !subtitle.isEmpty(); }
+    };
+    using Callback = std::function<void(const QVector<Result>&)>;
+    SubtitleLoader(QObject *parent = nullptr);
+    ~SubtitleLoader();
+    auto load(const QVector<Task> &tasks, Callback &&cb) -> void;
+    // run a task in caller's thread
+    static auto run(const Task &task) -> Result;
+    auto cancel() -> void;
+    auto isLoading() const -> bool;
+private:
+    auto customEvent(QEvent *event) -> void final;
+    struct Batch;
+    using BatchPtr = QSharedPointer<Batch>;
+    class Job;
+    struct Data;
+    Data *d;
+};
+
+#endif // SUBTITLELOADER_HPP
@@ -11,6 +11,8 @@ SIA operator < (int lhs, const SubCompModelData &rhs) -> bool
 struct SubCompModel::Data {
     bool visible = false, ms = false, fps = false;
     QString name;
+    SubCompIndexPtr index;
+    QVector<int> positions; // position in index for each row
 };
 
 SubCompModel::SubCompModel(QObject *parent)
@@ -26,28 +28,60 @@ auto SubCompModel::setComponent(const SubComp &comp) -> void
     d->name = comp.name();
     d->fps = comp.isBasedOnFrame();
 
-    auto it = comp.begin();
+    const auto index = comp.index();
+    d->index = index;
+    d->positions.clear();
     QList<SubCompModelData> list;
-    for (; it != comp.end(); ++it) {
-        if (it->hasWords()) {
-            it->index = 0;
-            list.append(it);
+    list.reserve(index->size());
+    int i = 0;
+    for (; i < index->size(); ++i) {
+        if (index->caption(i).hasWords()) {
+            index->caption(i).index = 0;
+            list.append(index->iterator(i));
+            d->positions.push_back(i);
             break;
         }
     }
     if (!list.isEmpty()) {
-        for (++it; it != comp.end(); ++it) {
+        for (++i; i < index->size(); ++i) {
             auto &last = list.last();
             if (last.m_end < 0)
-                last.m_end = it.key();
-            if (it->hasWords())
-                list.append(it);
-            it->index = list.size() - 1;
+                last.m_end = index->key(i);
+            const auto &caption = index->caption(i);
+            if (caption.hasWords()) {
+                list.append(index->iterator(i));
+                d->positions.push_back(i);
+            }
+            caption.index = list.size() - 1;
         }
     }
     setList(list);
 }
 
+auto SubCompModel::find(const MatchString &caption) const -> QVector<int>
+{
+    QVector<int> rows;
+    if (!caption.isValid())
+        return rows;
+    if (caption.isRegEx() || !d->index) {
+        for (int row = 0; row < size(); ++row) {
+            if (caption.contains(at(row).text()))
+                rows.push_back(row);
+        }
+        return rows;
+    }
+    const auto &pos = d->positions;
+    for (auto i : d->index->search(caption.string())) {
+        const auto it = std::lower_bound(pos.begin(), pos.end(), i);
+        if (it == pos.end() || *it != i)
+            continue;
+        const int row = it - pos.begin();
+        if (caption.contains(at(row).text()))
+            rows.push_back(row);
+    }
+    return rows;
+}
+
 auto SubCompModel::header(int column) const -> QString
 {
     switch (column) {
@@ -116,13 +150,44 @@ class SubCompFilterModel : public QSortFilterProxyModel {
             return false;
         if (end >= 0 && m->at(srow).start() > end)
             return false;
-        if (caption.string().isEmpty() || !caption.isValid())
+        // stale until source change is handled by updateMatched()
+        if (!all && matched.size() != m->size())
             return true;
-        return caption.contains(m->at(srow).text());
+        return all || matched.value(srow);
     }
+    auto updateMatched() -> void
+    {
+        auto m = static_cast<SubCompModel*>(sourceModel());
+        all = !m || caption.string().isEmpty() || !caption.isValid();
+        matched.clear();
+        if (all)
+            return;
+        matched.resize(m->size());
+        for (auto row : m->find(caption))
+            matched[row] = true;
+    }
+    MatchString caption;
+    QVector<QMetaObject::Connection> connections;
 public:
+    auto setSourceModel(QAbstractItemModel *model) -> void final
+    {
+        for (auto &c : connections)
+            disconnect(c);
+        connections.clear();
+        QSortFilterProxyModel::setSourceModel(model);
+        updateMatched();
+        if (!model)
+            return;
+        auto refilter = [=] () { updateMatched(); invalidateFilter(); };
+        connections.push_back(connect(model, &QAbstractItemModel::modelReset, this, refilter));
+        connections.push_back(connect(model, &QAbstractItemModel::rowsInserted, this, refilter));
+        connections.push_back(connect(model, &QAbstractItemModel::rowsRemoved, this, refilter));
+    }
+    auto setCaption(const MatchString &caption) -> void
+        { this->caption = caption; updateMatched(); }
     int start = -1, end = -1;
-    MatchString caption;
+    bool all = true;
+    QVector<bool> matched;
 };
 
 struct SubCompView::Data {
@@ -229,7 +294,7 @@ auto SubCompView::setFilter(int start, int end, const MatchString &caption) -> v
 {
     d->proxy.start = start;
     d->proxy.end = end;
-    d->proxy.caption = caption;
+    d->proxy.setCaption(caption);
     d->proxy.invalidate();
 }
 
@@ -32,6 +32,8 @@ public:
     auto setVisible(bool visible) -> void;
     auto setTimeInMilliseconds(bool ms) -> void;
     auto setComponent(const SubComp &comp) -> void;
+    // ascending rows whose text contains caption
+    auto find(const MatchString &caption) const -> QVector<int>;
 private:
     auto header(int column) const -> QString final;
     auto displayData(int row, int column) const -> QVariant final;
@@ -0,0 +1,190 @@
+#include "subtitlerasterizer.hpp"
+#include "subtitledrawer.hpp"
+#include "misc/log.hpp"
+#include <QThreadPool>
+#include <QRunnable>
+#include <QTemporaryDir>
+
+DECLARE_LOG_CONTEXT(Subtitle)
+
+static const QString BlankFile = u"blank.png"_q;
+static const QString ListFile = u"overlay.ffconcat"_q;
+
+struct SubtitleRasterizer::Data {
+    // caption image shown from start in ms
+    struct Entry { int start, pos; QString file; };
+    SubtitleRasterizer *p = nullptr;
+    OsdStyle style;
+    QSize size;
+    double fps = 0.0;
+    QThreadPool pool;
+    QScopedPointer<QTemporaryDir> dir;
+    // jobs read captions through index while caller's component may be gone
+    SubComp comp;
+    SubCompIndexPtr index;
+    QVector<Entry> entries;
+    std::atomic<bool> cancelled{false};
+    std::atomic<int> until{_Max<int>()};
+    mutable QMutex mutex;
+    QVector<bool> done; // guarded by mutex
+    int ready = 0;      // guarded by mutex
+
+    auto blank() const -> QImage
+    {
+        QImage image(size, QImage::Format_ARGB32_Premultiplied);
+        image.fill(0x0);
+        return image;
+    }
+    auto render(int i) -> bool
+    {
+        SubtitleDrawer drawer;
+        drawer.setStyle(style);
+        drawer.setAlignment(Qt::AlignBottom | Qt::AlignHCenter);
+        const QRectF area(QPointF(0, 0), size);
+        auto frame = blank();
+        QImage sub; int gap = 0;
+        const auto boxes = drawer.draw(sub, gap, index->caption(entries[i].pos), area);
+        if (!sub.isNull()) {
+            drawer.composeBoxes(sub, boxes);
+            QPainter painter(&frame);
+            painter.drawImage(drawer.pos(sub.size(), area), sub);
+        }
+        return frame.save(dir->filePath(entries[i].file), "png");
+    }
+    auto finish(int i) -> void
+    {
+        QMutexLocker locker(&mutex);
+        done[i] = true;
+        while (ready < done.size() && done[ready])
+            ++ready;
+        until = ready < entries.size() ? entries[ready].start : _Max<int>();
+    }
+};
+
+class SubtitleRasterizer::Job : public QRunnable {
+public:
+    Job(Data *d, int i): d(d), m_i(i) { }
+private:
+    auto run() -> void final
+    {
+        if (d->cancelled)
+            return;
+        if (!d->render(m_i))
+            _Error("Cannot write %%", d->entries[m_i].file);
+        d->finish(m_i);
+        emit d->p->progressed();
+    }
+    Data *d = nullptr;
+    const int m_i;
+};
+
+SubtitleRasterizer::SubtitleRasterizer(QObject *parent)
+    : QObject(parent), d(new Data)
+{
+    d->p = this;
+    d->pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+}
+
+SubtitleRasterizer::~SubtitleRasterizer()
+{
+    cancel();
+    d->pool.waitForDone();
+    delete d;
+}
+
+auto SubtitleRasterizer::setStyle(const OsdStyle &style) -> void
+{
+    d->style = style;
+}
+
+auto SubtitleRasterizer::setFrameSize(const QSize &size) -> void
+{
+    d->size = size;
+}
+
+auto SubtitleRasterizer::setFps(double fps) -> void
+{
+    d->fps = fps;
+}
+
+auto SubtitleRasterizer::start(const SubComp &comp, int begin, int end) -> bool
+{
+    cancel();
+    d->pool.waitForDone();
+    d->cancelled = false;
+    d->entries.clear();
+    d->dir.reset(new QTemporaryDir(QDir::tempPath() % "/bomi-subtitle-XXXXXX"_a));
+    if (!d->dir->isValid() || d->size.isEmpty()
+            || (comp.isBasedOnFrame() && d->fps <= 0.0))
+        return false;
+    if (!d->blank().save(d->dir->filePath(BlankFile), "png"))
+        return false;
+
+    // image of each caption is shown until next caption starts
+    QByteArray list = "ffconcat version 1.0\n";
+    int t = 0;
+    auto append = [&] (const QString &file, int until) {
+        if (until <= t)
+            return false;
+        list += "file '" + file.toLatin1() + "'\nduration "
+                + QByteArray::number((until - t) * 1e-3, 'f', 3) + '\n';
+        t = until;
+        return true;
+    };
+    d->comp = comp;
+    d->index = d->comp.index();
+    const auto &index = *d->index;
+    for (int i = 0; i < index.size(); ++i) {
+        const int start = d->comp.toTime(index.key(i), d->fps);
+        if (start >= end)
+            break;
+        const int next = i + 1 < index.size()
+                ? d->comp.toTime(index.key(i + 1), d->fps) : _Max<int>();
+        if (next <= begin || !index.caption(i).hasWords())
+            continue;
+        append(BlankFile, start);
+        const Data::Entry entry{t, i, _N(d->entries.size()).rightJustified(6, '0'_q) % ".png"_a};
+        if (append(entry.file, qMin(next, end)))
+            d->entries.push_back(entry);
+    }
+    append(BlankFile, end + 60000);
+
+    QFile file(d->dir->filePath(ListFile));
+    if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(list) != list.size())
+        return false;
+    file.close();
+
+    d->done.fill(false, d->entries.size());
+    d->ready = 0;
+    d->until = d->entries.isEmpty() ? _Max<int>() : d->entries.first().start;
+    for (int i = 0; i < d->entries.size(); ++i)
+        d->pool.start(new Job(d, i));
+    return true;
+}
+
+auto SubtitleRasterizer::cancel() -> void
+{
+    d->cancelled = true;
+    d->pool.clear();
+}
+
+auto SubtitleRasterizer::isFinished() const -> bool
+{
+    QMutexLocker locker(&d->mutex);
+    return d->ready >= d->done.size();
+}
+
+auto SubtitleRasterizer::readyUntil() const -> int
+{
+    return d->until;
+}
+
+auto SubtitleRasterizer::filterGraph() const -> QByteArray
+{
+    if (!d->dir || !d->dir->isValid())
+        return QByteArray();
+    // quoted for filter graph and escaped for option of movie filter
+    auto path = d->dir->filePath(ListFile).toUtf8();
+    path.replace('\\', "\\\\").replace(':', "\\:");
+    return "movie='" + path + "':f=concat[ov];[in][ov]overlay=eof_action=pass";
+}
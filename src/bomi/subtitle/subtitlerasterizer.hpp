@@ -0,0 +1,36 @@
+#ifndef SUBTITLERASTERIZER_HPP
+#define SUBTITLERASTERIZER_HPP
+
+#include "subtitle.hpp"
+
+class OsdStyle;
+
+// Draws captions of a component with SubtitleDrawer into frame sized images
+// in worker threads and lists them with their durations in ffconcat format.
+// The list is written first, so an encoder can overlay it by lavfi while
+// images are still drawn in order; readyUntil() tells how far it can go.
+class SubtitleRasterizer : public QObject {
+    Q_OBJECT
+public:
+    SubtitleRasterizer(QObject *parent = nullptr);
+    ~SubtitleRasterizer();
+    auto setStyle(const OsdStyle &style) -> void;
+    auto setFrameSize(const QSize &size) -> void;
+    auto setFps(double fps) -> void;
+    // returns false if images cannot be written
+    auto start(const SubComp &comp, int begin, int end) -> bool;
+    auto cancel() -> void;
+    auto isFinished() const -> bool;
+    // images for all captions before this time in ms are written
+    auto readyUntil() const -> int;
+    // filter graph for vf=lavfi which overlays images on its input
+    auto filterGraph() const -> QByteArray;
+signals:
+    void progressed();
+private:
+    class Job;
+    struct Data;
+    Data *d;
+};
+
+#endif // SUBTITLERASTERIZER_HPP
@@ -1,9 +1,11 @@
 #include "subtitlerenderer.hpp"
 #include "subtitlerenderingthread.hpp"
 #include "misc/dataevent.hpp"
+#include "misc/matchstring.hpp"
 #include "enum/autoselectmode.hpp"
 #include "opengl/opengltexture2d.hpp"
 #include "opengl/opengltexturebinder.hpp"
+#include "opengl/openglbenchmarker.hpp"
 
 struct SubtitleShaderData : public SubtitleRenderer::ShaderData {
     const OpenGLTexture2D *texture, *bbox;
@@ -50,6 +52,10 @@ struct SubtitleShader : public SubtitleRenderer::ShaderIface {
         prog->setUniformValue(loc_bboxColor, d->bboxColor);
         f->glActiveTexture(GL_TEXTURE0);
     }
+    auto beforeUpdate() -> void final
+        { OpenGLBenchmarker::instance().begin(OpenGLBenchmarker::Subtitle); }
+    auto afterUpdate() -> void final
+        { OpenGLBenchmarker::instance().end(OpenGLBenchmarker::Subtitle); }
 private:
     int loc_tex = -1, loc_bbox = -1, loc_bboxColor = -1;
 };
@@ -199,27 +205,7 @@ auto SubtitleRenderer::draw(const QRectF &rect, QRectF *put) const -> QImage
         return QImage();
     if (put)
         *put = {d->drawer.pos(sub.size(), rect), sub.size()};
-    if (!boxes.isEmpty()) {
-        QImage bg(sub.size(), QImage::Format_ARGB32_Premultiplied);
-        bg.fill(0x0);
-        QPainter painter(&bg);
-        auto bcolor = d->drawer.style().bbox.color;
-        bcolor.setAlpha(255);
-        for (auto &bbox : boxes)
-            painter.fillRect(bbox, bcolor);
-        auto p = bg.bits();
-        for (int i=0; i<bg.width(); ++i) {
-            for (int j=0; j<bg.height(); ++j) {
-                *p++ *= d->drawer.style().bbox.color.alphaF();
-                *p++ *= d->drawer.style().bbox.color.alphaF();
-                *p++ *= d->drawer.style().bbox.color.alphaF();
-                *p++ *= d->drawer.style().bbox.color.alphaF();
-            }
-        }
-        painter.drawImage(QPoint(0, 0), sub);
-        painter.end();
-        sub.swap(bg);
-    }
+    d->drawer.composeBoxes(sub, boxes);
     return sub;
 }
 
@@ -309,6 +295,8 @@ auto SubtitleRenderer::updateTexture(OpenGLTexture2D *texture) -> void
     });
     d->imageSize.rheight() -= spacing;
     if (!d->imageSize.isEmpty()) {
+        auto &bm = OpenGLBenchmarker::instance();
+        bm.begin(OpenGLBenchmarker::Subtitle);
         const auto len = d->imageSize.width()*d->imageSize.height();
         _Expand(d->zeros, len);
         OpenGLTextureBinder<OGL::Target2D> binder;
@@ -332,6 +320,7 @@ auto SubtitleRenderer::updateTexture(OpenGLTexture2D *texture) -> void
             }
             y += image.height() + spacing;
         });
+        bm.end(OpenGLBenchmarker::Subtitle);
         reserve(UpdateGeometry, false);
     }
     if (_Change(d->lastTime, lastTime))
@@ -479,6 +468,29 @@ auto SubtitleRenderer::finish(int time) const -> int
     return ret;
 }
 
+auto SubtitleRenderer::find(const QString &text, int time) const -> int
+{
+    const MatchString match(text);
+    int after = -1, first = -1;
+    d->selection.forComponents([&] (const SubComp &comp) {
+        const auto index = comp.index();
+        for (auto i : index->search(text)) {
+            if (!match.contains(index->caption(i).toPlainText()))
+                continue;
+            // positions are ascending, and so are times
+            const int t = comp.toTime(index->key(i), d->fps()) + d->delay;
+            if (first < 0 || t < first)
+                first = t;
+            if (t > time) {
+                if (after < 0 || t < after)
+                    after = t;
+                break;
+            }
+        }
+    });
+    return after < 0 ? first : after;
+}
+
 static bool updateIfEarlier(SubComp::ConstIt it, int &time) {
     if (it->hasWords()) {
         if (time < 0)
@@ -581,6 +593,11 @@ auto SubtitleRenderer::customEvent(QEvent *event) -> void
     }
 }
 
+auto SubtitleRenderer::setPrerenderWindow(int ms) -> void
+{
+    SubCompSelection::setPrerenderWindow(ms);
+}
+
 auto SubtitleRenderer::toTrackList() const -> StreamList
 {
     StreamList list(StreamInclusiveSubtitle);
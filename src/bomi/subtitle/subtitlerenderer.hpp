@@ -19,6 +19,8 @@ public:
     auto current() const -> int;
     auto start(int pos) const -> int;
     auto finish(int pos) const -> int;
+    // start time of first caption after pos containing text, wrapping around
+    auto find(const QString &text, int pos) const -> int;
     auto delay() const -> int;
     auto fps() const -> double;
     auto pos() const -> double;
@@ -47,6 +49,7 @@ public:
     auto setFPS(double fps) -> void;
     auto toTrackList() const -> StreamList;
     auto lastUpdatedTime() const -> int;
+    static auto setPrerenderWindow(int ms) -> void;
 //    auto load(const QVector<StreamTrack> &tracks) -> void;
 signals:
     void updated(int time);
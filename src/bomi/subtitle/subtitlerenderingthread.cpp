@@ -1,168 +1,381 @@
 #include "subtitlerenderingthread.hpp"
 #include "misc/dataevent.hpp"
+#include <QJsonDocument>
 
-template<>
-inline bool qMapLessThanKey(const SubCompItMapIt &lhs,
-                            const SubCompItMapIt &rhs) {
-    return lhs.key() < rhs.key();
+static constexpr const int NewOption = SubCompSelection::NewDrawer
+                                     | SubCompSelection::NewArea;
+static constexpr const int ForceUpdate = SubCompSelection::Rerender
+                                       | SubCompSelection::Rebuild | NewOption;
+// cached images of all components share this budget
+static constexpr const qint64 CacheBudget = 64 * 1024 * 1024;
+// captions starting in this period from now are rendered in advance
+static std::atomic<int> s_prerender{30000};
+
+// fps is 0 for time-based components whose keys don't depend on it
+static auto optionsHash(const SubtitleDrawer &drawer, const QRectF &rect,
+                        double dpr, double fps) -> uint
+{
+    const auto &m = drawer.margin();
+    const double values[] = { rect.x(), rect.y(), rect.width(), rect.height(),
+                              dpr, m.top, m.right, m.bottom, m.left, fps };
+    auto hash = qHashBits(values, sizeof(values));
+    hash = qHash((int)drawer.alignment(), hash);
+    const auto style = QJsonDocument(drawer.style().toJson());
+    return qHash(style.toJson(QJsonDocument::Compact), hash);
 }
 
-struct SubCompSelection::Thread::Data {
+class SubCompSelection::Pool {
+public:
+    static auto shared() -> QSharedPointer<Pool>;
+    ~Pool();
+    auto schedule(Renderer *r) -> void; // requires lock
+    auto cancel(Renderer *r) -> void;   // waits until r is not processed
+    auto run() -> void;
+    QMutex mutex;
+    std::atomic<qint64> cached{0};
+private:
+    Pool();
+    auto take() -> Renderer*;
+    QWaitCondition wake, done;
+    QList<Renderer*> queue;
+    QList<QThread*> threads;
+    bool quit = false;
+};
+
+struct SubCompSelection::Renderer::Data {
+    Pool *pool = nullptr;
+    // guarded by pool mutex
+    struct {
+        int time = 0, flags = 0;
+        double fps = 1.0, dpr = 1.0;
+        QRectF rect; SubtitleDrawer drawer;
+    } pending;
+    bool queued = false, running = false, prefetch = false;
+    // caption on screen is valid in [start, due)
+    int start = _Max<int>(), due = _Min<int>();
+
+    // only for the thread processing this
     Item *item = nullptr;
     int time = 0;
     const SubComp *comp = nullptr;
-    SubCompItMap its;
-    SubCompItMapIt it = its.end();
-    QMap<SubCompItMapIt, SubCompImage> pool;
+    SubCompIndexPtr index;
+    int pos = -1; // caption on screen in index, -1 if none
     QObject *receiver = nullptr;
-    bool quit = false;
-    double fps = 1.0, dpr = 1.0, mul = 1.0;
-    QMutex *mutex; QWaitCondition *wait;
+    double fps = 1.0, dpr = 1.0;
     QRectF rect; SubtitleDrawer drawer;
-    SubCompSelection *selection = nullptr;
 
-    SubComp::ConstIt iterator(int time) const { return comp->start(time, fps); }
-    auto newPicture(SubCompItMapIt it)
+    // rendered images by caption key and hash of drawing options,
+    // most recently used first
+    using CacheKey = QPair<int, uint>;
+    struct Cached { CacheKey key; SubCompImage image; };
+    std::list<Cached> lru;
+    QHash<CacheKey, std::list<Cached>::iterator> cache;
+    uint options = 0;
+
+    auto key(int pos) const -> CacheKey
+        { return qMakePair(index->key(pos), options); }
+    auto timeAt(int pos) const -> int
+        { return comp->toTime(index->key(pos), fps); }
+    auto find(int pos) -> const SubCompImage*
     {
-        auto pic = pool.insert(it, SubCompImage(comp, *it, item));
-        drawer.draw(*pic, rect, dpr);
+        auto c = cache.find(key(pos));
+        if (c == cache.end())
+            return nullptr;
+        lru.splice(lru.begin(), lru, *c);
+        return &lru.front().image;
+    }
+    auto insert(int pos) -> const SubCompImage&
+    {
+        lru.push_front({ key(pos), SubCompImage(comp, index->iterator(pos), item) });
+        auto &pic = lru.front().image;
+        drawer.draw(pic, rect, dpr);
+        cache.insert(lru.front().key, lru.begin());
+        pool->cached += pic.byteCount();
         return pic;
     }
+    auto evictLast()
+    {
+        pool->cached -= lru.back().image.byteCount();
+        cache.remove(lru.back().key);
+        lru.pop_back();
+    }
+    // evict least recently used ones until budget is met but keep at least n
+    auto shrink(int n) -> bool
+    {
+        while (pool->cached > CacheBudget && (int)lru.size() > n)
+            evictLast();
+        return pool->cached <= CacheBudget;
+    }
+    auto clearCache()
+    {
+        while (!lru.empty())
+            evictLast();
+    }
     auto update()
     {
-        if (quit)
-            return;
         auto post = [this] (const SubCompImage &pic)
             { _PostEvent(receiver, ImagePrepared, pic); };
-        if (it != its.end()) {
-            auto cache = pool.find(it);
-            if (cache == pool.end())
-                cache = newPicture(it);
-            post(*cache);
+        if (pos >= 0) {
+            auto pic = find(pos);
+            if (!pic) {
+                pic = &insert(pos);
+                shrink(1);
+            }
+            post(*pic);
         } else
             post(comp);
     }
 
-    auto fillCache()
+    // render one caption in look-ahead window, returns true if more remain
+    auto fillCache() -> bool
     {
-        if (it == its.end())
-            return;
-        auto iit = pool.begin();
-        while (iit != pool.end() && iit.key().key() < it.key())
-            iit = pool.erase(iit);
-        Q_ASSERT(iit.key() == it);
-        auto key = it;
-        const int size = qMin(2, pool.size()+1);
-        for (int i=0; i<size; ++i) {
-            ++iit; ++key;
-            if (key == its.end())
+        if (pos < 0 || !find(pos))
+            return false;
+        const qint64 until = qint64(time) + s_prerender.load();
+        int kept = 1;
+        for (int next = pos + 1; next < index->size(); ++next, ++kept) {
+            if (kept > 1 && timeAt(next) >= until)
                 break;
-            if (iit == pool.end())
-                iit = newPicture(key);
+            if (find(next))
+                continue;
+            if (!shrink(kept))
+                return false;
+            insert(next);
+            return true;
         }
+        return false;
     }
 
-    auto draw(bool force)
+    // returns true if caption on screen has changed
+    auto draw(bool force) -> bool
     {
-        auto iit = --its.upperBound(time);
-        if (force || it != iit) {
-            if (it == its.end() || ++it != iit) {
-                pool.clear();
-                it = iit;
-                update();
-            } else {
-                update();
-                fillCache();
-            }
-        }
+        const int found = index->find(comp->toKey(time, fps));
+        if (!force && pos == found)
+            return false;
+        pos = found;
+        update();
+        return true;
     }
 
     auto rebuild()
     {
-        pool.clear();
-        its.clear();
-        it = its.end();
-        for (auto iit = comp->begin(); iit != comp->end(); ++iit)
-            its.insert(comp->toTime(iit.key(), fps), iit);
+        index = comp->index();
+        pos = -1;
+    }
+
+    // requires lock
+    auto isChanged() const -> bool
+        { return (pending.flags & ForceUpdate) || pending.time < start || pending.time >= due; }
+    auto updateInterval() -> void
+    {
+        if (!index || index->isEmpty() || fps <= 0.0) {
+            start = _Min<int>(); due = _Max<int>();
+        } else if (pos < 0) {
+            start = _Min<int>(); due = timeAt(0);
+        } else {
+            start = timeAt(pos);
+            due = pos + 1 < index->size() ? timeAt(pos + 1) : _Max<int>();
+        }
     }
 };
 
-SubCompSelection::Thread::Thread(QMutex *mutex, QWaitCondition *wait,
-                                 Item *item, SubCompSelection *selection,
-                                 QObject *renderer)
-    : QThread()
-    , d(new Data)
+SubCompSelection::Renderer::Renderer(Item *item, QObject *receiver,
+                                     const QSharedPointer<Pool> &pool)
+    : d(new Data)
 {
     d->item = item;
     d->comp = item->comp;
-    d->receiver = renderer;
-    d->mutex = mutex;
-    d->wait = wait;
-    d->selection = selection;
+    d->receiver = receiver;
+    d->pool = pool.data();
 }
 
-SubCompSelection::Thread::~Thread()
+SubCompSelection::Renderer::~Renderer()
 {
-    finish();
+    d->pool->cancel(this);
+    d->clearCache();
     delete d;
 }
 
-auto SubCompSelection::Thread::setFPS(double fps) -> void
+auto SubCompSelection::Renderer::setFPS(double fps) -> void
 {
-    this->fps = fps;
-    flags |= Rebuild;
+    QMutexLocker locker(&d->pool->mutex);
+    d->pending.fps = fps;
+    d->pending.flags |= Rebuild;
+    d->pool->schedule(this);
 }
 
-auto SubCompSelection::Thread::finish() -> void
+auto SubCompSelection::Renderer::setArea(const QRectF &rect, double dpr) -> void
 {
-    d->quit = true;
-    d->wait->wakeAll();
-    if (!wait(5000))
-        terminate();
+    QMutexLocker locker(&d->pool->mutex);
+    d->pending.rect = rect;
+    d->pending.dpr = dpr;
+    d->pending.flags |= NewArea;
+    d->pool->schedule(this);
 }
 
-auto SubCompSelection::Thread::run() -> void
+auto SubCompSelection::Renderer::setDrawer(const SubtitleDrawer &drawer) -> void
 {
-    static constexpr int NewOption = NewDrawer | NewArea;
-    static constexpr int ForceUpdate = Rerender | Rebuild | NewOption;
-    int flags = 0;
-    while (!d->quit) {
-        QMutexLocker locker(d->mutex);
-        if (!(this->flags & ForceUpdate))
-            d->wait->wait(d->mutex);
-        if (d->quit)
-            break;
-        flags = this->flags;
-        this->flags = 0;
-        d->time = time;
-        d->fps = fps;
-        if (flags & NewOption) {
-            if (flags & NewDrawer)
-                d->drawer = drawer;
-            if (flags & NewArea) {
-                d->rect = rect;
-                d->dpr = dpr;
-            }
+    QMutexLocker locker(&d->pool->mutex);
+    d->pending.drawer = drawer;
+    d->pending.flags |= NewDrawer;
+    d->pool->schedule(this);
+}
+
+auto SubCompSelection::Renderer::render(int time, int flags) -> void
+{
+    QMutexLocker locker(&d->pool->mutex);
+    d->pending.time = time;
+    d->pending.flags |= flags & ForceUpdate;
+    // ticks inside of the caption on screen don't need any work
+    if (d->isChanged())
+        d->pool->schedule(this);
+}
+
+auto SubCompSelection::Renderer::process() -> void
+{
+    auto &mutex = d->pool->mutex;
+    mutex.lock();
+    const int flags = d->pending.flags;
+    const bool prefetch = d->prefetch;
+    d->pending.flags = 0;
+    d->prefetch = false;
+    d->time = d->pending.time;
+    d->fps = d->pending.fps;
+    if (flags & NewDrawer)
+        d->drawer = d->pending.drawer;
+    if (flags & NewArea) {
+        d->rect = d->pending.rect;
+        d->dpr = d->pending.dpr;
+    }
+    mutex.unlock();
+
+    if (flags & Rebuild)
+        d->rebuild();
+    // images for other options are kept for a while to switch back
+    if (flags & (NewOption | Rebuild)) {
+        const double fps = d->comp->isBasedOnFrame() ? d->fps : 0.0;
+        d->options = optionsHash(d->drawer, d->rect, d->dpr, fps);
+    }
+    bool changed = false, more = false;
+    if (d->time > 0 && d->fps > 0.0 && d->index && !d->index->isEmpty()) {
+        changed = d->draw(flags & ForceUpdate);
+        if (!changed && prefetch)
+            more = d->fillCache();
+    }
+
+    mutex.lock();
+    d->updateInterval();
+    // render next captions later unless other one is due earlier
+    d->prefetch = changed || more;
+    mutex.unlock();
+}
+
+/******************************************************************************/
+
+class SubtitleRenderingWorker : public QThread {
+public:
+    SubtitleRenderingWorker(std::function<void(void)> &&run)
+        : m_run(std::move(run)) { }
+private:
+    auto run() -> void final { m_run(); }
+    std::function<void(void)> m_run;
+};
+
+SubCompSelection::Pool::Pool()
+{
+    const int count = qBound(1, QThread::idealThreadCount() - 1, 2);
+    for (int i = 0; i < count; ++i) {
+        threads.push_back(new SubtitleRenderingWorker([this] () { run(); }));
+        threads.back()->start();
+    }
+}
+
+SubCompSelection::Pool::~Pool()
+{
+    mutex.lock();
+    quit = true;
+    wake.wakeAll();
+    mutex.unlock();
+    for (auto thread : threads) {
+        if (!thread->wait(5000))
+            thread->terminate();
+    }
+    qDeleteAll(threads);
+}
+
+auto SubCompSelection::setPrerenderWindow(int ms) -> void
+{
+    s_prerender = qMax(0, ms);
+}
+
+auto SubCompSelection::Pool::shared() -> QSharedPointer<Pool>
+{
+    static QWeakPointer<Pool> weak;
+    auto pool = weak.toStrongRef();
+    if (!pool) {
+        pool.reset(new Pool);
+        weak = pool;
+    }
+    return pool;
+}
+
+auto SubCompSelection::Pool::schedule(Renderer *r) -> void
+{
+    auto d = r->d;
+    if (!d->queued && !d->prefetch && !d->running)
+        queue.push_back(r);
+    d->queued = true;
+    wake.wakeOne();
+}
+
+auto SubCompSelection::Pool::cancel(Renderer *r) -> void
+{
+    QMutexLocker locker(&mutex);
+    while (r->d->running)
+        done.wait(&mutex);
+    // run() may have queued r again while processing, so drop after waiting
+    queue.removeOne(r);
+    r->d->queued = r->d->prefetch = false;
+}
+
+auto SubCompSelection::Pool::take() -> Renderer*
+{
+    // changed captions first, then prefetching, both by the time due
+    auto rank = [] (const Renderer *r) {
+        return qMakePair(r->d->queued ? 0 : 1, r->d->due);
+    };
+    auto it = std::min_element(queue.begin(), queue.end(),
+        [&] (const Renderer *lhs, const Renderer *rhs)
+            { return rank(lhs) < rank(rhs); });
+    auto r = *it;
+    queue.erase(it);
+    r->d->queued = false;
+    r->d->running = true;
+    return r;
+}
+
+auto SubCompSelection::Pool::run() -> void
+{
+    QMutexLocker locker(&mutex);
+    while (!quit) {
+        if (queue.isEmpty()) {
+            wake.wait(&mutex);
+            continue;
         }
+        auto r = take();
         locker.unlock();
-        if (d->quit)
-            break;
-        if (flags & Rebuild)
-            d->rebuild();
-        if (flags & NewOption)
-            d->pool.clear();
-        if (d->quit)
-            break;
-        if (d->time > 0 && d->fps > 0.0 && !d->its.isEmpty())
-            d->draw(flags & ForceUpdate);
+        r->process();
+        locker.relock();
+        r->d->running = false;
+        if (r->d->queued || r->d->prefetch)
+            queue.push_back(r);
+        done.wakeAll();
     }
 }
 
-/******************************************************************************/
 
 struct SubCompSelection::Data {
-    QMutex mutex;
-    QWaitCondition wait;
+    QSharedPointer<Pool> pool = Pool::shared();
     QObject *renderer = nullptr;
     SubtitleDrawer drawer;
     QRectF rect;
@@ -177,6 +390,8 @@ SubCompSelection::SubCompSelection(QObject *renderer)
 
 SubCompSelection::~SubCompSelection()
 {
+    for (auto &item : items)
+        _Delete(item.renderer);
     delete d;
 }
 
@@ -197,14 +412,13 @@ auto SubCompSelection::drawer() const -> const SubtitleDrawer&
 auto SubCompSelection::setDrawer(const SubtitleDrawer &drawer) -> void
 {
     d->drawer = drawer;
-    forThreads([this] (Thread *t) { t->setDrawer(d->drawer); });
+    forRenderers([this] (Renderer *r) { r->setDrawer(d->drawer); });
 }
 
 auto SubCompSelection::clear() -> void
 {
     for (auto &item : items)
-        item.thread->finish();
-    wait.wakeAll();
+        _Delete(item.renderer);
     qApp->removePostedEvents(d->renderer, ImagePrepared);
     for (auto &item : items)
         item.release();
@@ -216,7 +430,7 @@ auto SubCompSelection::setArea(const QRectF &rect, double dpr) -> void
     if (d->rect == rect && d->dpr == dpr)
         return;
     d->rect = rect; d->dpr = dpr;
-    forThreads([this] (Thread *thread) { thread->setArea(d->rect, d->dpr); });
+    forRenderers([this] (Renderer *r) { r->setArea(d->rect, d->dpr); });
 }
 
 auto SubCompSelection::isEmpty() const -> bool
@@ -235,11 +449,10 @@ auto SubCompSelection::prepend(const SubComp *comp) -> bool
     items.push_front(Item());
     auto &item = items.front();
     item.comp = comp;
-    item.thread = new Thread(&mutex, &wait, &item, this, d->renderer);
-    item.thread->setFPS(d->fps);
-    item.thread->setDrawer(d->drawer);
-    item.thread->setArea(d->rect, d->dpr);
-    item.thread->start();
+    item.renderer = new Renderer(&item, d->renderer, d->pool);
+    item.renderer->setFPS(d->fps);
+    item.renderer->setDrawer(d->drawer);
+    item.renderer->setArea(d->rect, d->dpr);
     return true;
 }
 
@@ -251,7 +464,7 @@ auto SubCompSelection::fps() const -> double
 auto SubCompSelection::setFPS(double fps) -> void
 {
     if (_Change(d->fps, fps))
-        forThreads([this, fps] (Thread *t) { t->setFPS(fps); });
+        forRenderers([fps] (Renderer *r) { r->setFPS(fps); });
 }
 
 auto SubCompSelection::update(const SubCompImage &image) -> bool
@@ -3,9 +3,6 @@
 
 #include "subtitledrawer.hpp"
 
-using SubCompItMap = QMap<int, SubComp::ConstIt>;
-using SubCompItMapIt = SubCompItMap::const_iterator;
-
 class SubCompSelection {
 public:
     static constexpr int ImagePrepared = QEvent::User+1;
@@ -14,27 +11,24 @@ public:
     };
 private:
     struct Item;
-    class Thread : public QThread {
+    class Pool;
+    // rendering state of a component, processed by threads of shared Pool
+    class Renderer {
     public:
-        Thread(QMutex *mutex, QWaitCondition *wait, Item *item,
-               SubCompSelection *selection, QObject *renderer);
-        ~Thread();
+        Renderer(Item *item, QObject *receiver, const QSharedPointer<Pool> &pool);
+        ~Renderer();
         auto setFPS(double fps) -> void;
         auto render(int time, int flags) -> void;
         auto setArea(const QRectF &rect, double dpr) -> void;
         auto setDrawer(const SubtitleDrawer &drawer) -> void;
-        auto finish() -> void;
-        auto run() -> void;
     private:
-        QRectF rect;
-        double dpr = 1.0, fps = 1.0;
-        SubtitleDrawer drawer;
-        int time = 0, flags = 0;
+        friend class Pool;
+        auto process() -> void;
         struct Data; Data *d;
     };
     struct Item {
         auto release() -> void;
-        Thread *thread  = nullptr;
+        Renderer *renderer = nullptr;
         const SubComp *comp = nullptr;
         SubCompImage image{nullptr};
     };
@@ -62,29 +56,20 @@ public:
     auto setFPS(double fps) -> void;
     auto setMargin(double top, double bottom,
                    double right, double left) -> void;
+    // captions starting within ms from now are rendered in advance
+    static auto setPrerenderWindow(int ms) -> void;
 private:
     auto item(const SubCompImage &image) -> Item*;
     auto find(const SubComp *comp) -> List::iterator;
     auto find(const SubComp *comp) const -> List::const_iterator;
     template<class Func>
-    auto forThreads(Func func) -> void;
-    List items; mutable QMutex mutex;
-    mutable QWaitCondition wait;
+    auto forRenderers(Func func) -> void;
+    List items;
     struct Data;
     Data *d;
     QVector<SubCompImage> m_images;
 };
 
-inline auto SubCompSelection::Thread::render(int time, int flags) -> void
-{ this->time = time; this->flags |= flags; }
-
-inline auto SubCompSelection::Thread::setArea(const QRectF &rect,
-                                              double dpr) -> void
-{ this->rect = rect; this->dpr = dpr; flags |= NewArea; }
-
-inline auto SubCompSelection::Thread::setDrawer(const SubtitleDrawer &d) -> void
-{ this->drawer = d; flags |= NewDrawer; }
-
 template<class LessThan>
 inline auto SubCompSelection::sort(LessThan lt) -> void
 {
@@ -102,11 +87,11 @@ inline auto SubCompSelection::forImages(F f) const -> void
 { for (const auto &item : items) f(item.image); }
 
 inline auto SubCompSelection::render(int ms, int flags) -> void
-{ forThreads([this, ms, flags] (Thread *t) { t->render(ms, flags); }); }
+{ forRenderers([ms, flags] (Renderer *r) { r->render(ms, flags); }); }
 
 inline auto SubCompSelection::Item::release() -> void
 {
-    _Delete(thread);
+    _Delete(renderer);
     if (comp)
         const_cast<SubComp*>(comp)->selection() = false;
 }
@@ -134,12 +119,9 @@ inline auto SubCompSelection::find(const SubComp *comp) const
 }
 
 template<class Func>
-inline auto SubCompSelection::forThreads(Func func) -> void {
-    mutex.lock();
+inline auto SubCompSelection::forRenderers(Func func) -> void {
     for (const auto &item : items)
-        func(item.thread);
-    mutex.unlock();
-    wait.wakeAll();
+        func(item.renderer);
 }
 
 #endif // SUBTITLERENDERINGTHREAD_HPP
@@ -0,0 +1,266 @@
+#include "frametiming.hpp"
+#include "opengl/openglbenchmarker.hpp"
+#include <deque>
+
+static constexpr const int WindowSize = 600;
+// gaps longer than this are pauses or seeks rather than judder
+static constexpr const qint64 MaxInterval = 250000000;
+
+struct FrameTimingRecorder::Data {
+    // ticket of OpenGLBenchmarker for gpu time, read back frames later
+    struct Pending { FrameTimingSample sample; quint64 ticket = 0; };
+    QElapsedTimer clock;
+    bool rendered = false;
+    Pending current;
+    std::deque<Pending> pending;
+    qint64 vsync = -1, lastSwap = 0;
+};
+
+FrameTimingRecorder::FrameTimingRecorder()
+    : d(new Data)
+{
+    d->clock.start();
+}
+
+FrameTimingRecorder::~FrameTimingRecorder()
+{
+    delete d;
+}
+
+auto FrameTimingRecorder::initializeGL(qreal refreshRate) -> void
+{
+    d->vsync = refreshRate > 1.0 ? qRound64(1e9 / refreshRate) : -1;
+}
+
+auto FrameTimingRecorder::finalizeGL() -> void
+{
+    d->rendered = false;
+    d->pending.clear();
+    d->lastSwap = 0;
+}
+
+auto FrameTimingRecorder::begin() -> void
+{
+    if (d->rendered) // previous frame has never been swapped
+        d->pending.push_back(d->current);
+    d->current = Data::Pending();
+    d->current.sample.start = d->clock.nsecsElapsed();
+    d->current.sample.vsync = d->vsync;
+    OpenGLBenchmarker::instance().begin(OpenGLBenchmarker::Frame);
+}
+
+auto FrameTimingRecorder::end() -> void
+{
+    auto &bm = OpenGLBenchmarker::instance();
+    const auto ticket = bm.end(OpenGLBenchmarker::Frame);
+    if (bm.isGpuTimer())
+        d->current.ticket = ticket;
+    d->current.sample.cpu = d->clock.nsecsElapsed() - d->current.sample.start;
+    d->rendered = true;
+}
+
+auto FrameTimingRecorder::swapped() -> void
+{
+    if (d->rendered) {
+        const auto now = d->clock.nsecsElapsed();
+        auto &s = d->current.sample;
+        s.swap = now - s.start;
+        if (d->lastSwap > 0)
+            s.interval = now - d->lastSwap;
+        d->lastSwap = now;
+        d->pending.push_back(d->current);
+        d->rendered = false;
+    }
+    flush();
+}
+
+auto FrameTimingRecorder::flush() -> void
+{
+    const auto &bm = OpenGLBenchmarker::instance();
+    while (!d->pending.empty()) {
+        auto &p = d->pending.front();
+        if (p.ticket) {
+            if (bm.completed() < p.ticket)
+                break;
+            p.sample.gpu = bm.elapsed(p.ticket);
+        }
+        m_ring.push(p.sample);
+        d->pending.pop_front();
+    }
+}
+
+/******************************************************************************/
+
+template<class T>
+SIA _Percentile(const QVector<T> &sorted, double p) -> T
+{
+    if (sorted.isEmpty())
+        return T(-1);
+    const int idx = qCeil(p * sorted.size()) - 1;
+    return sorted[qBound(0, idx, sorted.size() - 1)];
+}
+
+SIA _Ms(qint64 ns) -> qreal { return ns < 0 ? -1.0 : ns * 1e-6; }
+
+struct FrameTimingObject::Data {
+    QVector<FrameTimingSample> window;
+    int head = 0;
+    quint32 dropped = 0, droppedBase = 0;
+    qreal renderTime = -1, renderTimeP95 = -1, renderTimeP99 = -1;
+    qreal renderTimeMax = -1, gpuTime = -1, gpuTimeP99 = -1;
+    qreal swapLatencyP99 = -1, frameInterval = -1, frameIntervalP99 = -1;
+    qreal vsyncInterval = -1, judder = -1, cadenceBreaks = -1;
+    QList<int> renderHistogram, vsyncHistogram;
+    auto ordered() const -> QVector<FrameTimingSample>
+    {
+        if (window.size() < WindowSize)
+            return window;
+        return window.mid(head) + window.mid(0, head);
+    }
+    auto compute() -> void
+    {
+        const auto samples = ordered();
+        QVector<qint64> cpu, gpu, swap, interval;
+        cpu.reserve(samples.size());
+        interval.reserve(samples.size());
+        renderHistogram = QVector<int>(RenderBins, 0).toList();
+        vsyncHistogram = QVector<int>(VsyncBins, 0).toList();
+        qint64 vsync = -1;
+        int breaks = 0, cadences = 0, lastCount = 0;
+        double sum = 0, sum2 = 0;
+        for (auto &s : samples) {
+            cpu.push_back(s.cpu);
+            ++renderHistogram[qBound<int>(0, s.cpu / 1000000, RenderBins - 1)];
+            if (s.gpu >= 0)
+                gpu.push_back(s.gpu);
+            if (s.swap >= 0)
+                swap.push_back(s.swap);
+            if (s.vsync > 0)
+                vsync = s.vsync;
+            if (s.interval < 0 || s.interval > MaxInterval) {
+                lastCount = 0;
+                continue;
+            }
+            interval.push_back(s.interval);
+            sum += s.interval;
+            sum2 += double(s.interval) * s.interval;
+            if (s.vsync > 0) {
+                const int count = qMax(1, (int)qRound64(double(s.interval) / s.vsync));
+                ++vsyncHistogram[qMin(count, VsyncBins) - 1];
+                if (lastCount > 0) {
+                    ++cadences;
+                    if (count != lastCount)
+                        ++breaks;
+                }
+                lastCount = count;
+            }
+        }
+        for (auto v : { &cpu, &gpu, &swap, &interval })
+            std::sort(v->begin(), v->end());
+        renderTime = _Ms(_Percentile(cpu, 0.5));
+        renderTimeP95 = _Ms(_Percentile(cpu, 0.95));
+        renderTimeP99 = _Ms(_Percentile(cpu, 0.99));
+        renderTimeMax = _Ms(cpu.isEmpty() ? -1 : cpu.last());
+        gpuTime = _Ms(_Percentile(gpu, 0.5));
+        gpuTimeP99 = _Ms(_Percentile(gpu, 0.99));
+        swapLatencyP99 = _Ms(_Percentile(swap, 0.99));
+        frameIntervalP99 = _Ms(_Percentile(interval, 0.99));
+        vsyncInterval = _Ms(vsync);
+        if (interval.isEmpty()) {
+            frameInterval = judder = -1;
+        } else {
+            const double mean = sum / interval.size();
+            frameInterval = _Ms(mean);
+            judder = qSqrt(qMax(0.0, sum2 / interval.size() - mean * mean)) * 1e-6;
+        }
+        cadenceBreaks = cadences ? 100.0 * breaks / cadences : -1;
+    }
+};
+
+FrameTimingObject::FrameTimingObject()
+    : d(new Data)
+{
+    d->window.reserve(WindowSize);
+    d->compute();
+}
+
+FrameTimingObject::~FrameTimingObject()
+{
+    delete d;
+}
+
+auto FrameTimingObject::update(FrameTimingRing *ring) -> void
+{
+    const int count = ring->drain([&] (const FrameTimingSample &s) {
+        if (d->window.size() < WindowSize)
+            d->window.push_back(s);
+        else {
+            d->window[d->head] = s;
+            d->head = (d->head + 1) % WindowSize;
+        }
+    });
+    if (!count)
+        return;
+    d->dropped = ring->dropped();
+    d->compute();
+    emit statisticsChanged();
+}
+
+void FrameTimingObject::reset()
+{
+    d->window.clear();
+    d->head = 0;
+    d->droppedBase = d->dropped;
+    d->compute();
+    emit statisticsChanged();
+}
+
+auto FrameTimingObject::samples() const -> int { return d->window.size(); }
+auto FrameTimingObject::droppedSamples() const -> int { return d->dropped - d->droppedBase; }
+auto FrameTimingObject::renderTime() const -> qreal { return d->renderTime; }
+auto FrameTimingObject::renderTimeP95() const -> qreal { return d->renderTimeP95; }
+auto FrameTimingObject::renderTimeP99() const -> qreal { return d->renderTimeP99; }
+auto FrameTimingObject::renderTimeMax() const -> qreal { return d->renderTimeMax; }
+auto FrameTimingObject::gpuTime() const -> qreal { return d->gpuTime; }
+auto FrameTimingObject::gpuTimeP99() const -> qreal { return d->gpuTimeP99; }
+auto FrameTimingObject::swapLatencyP99() const -> qreal { return d->swapLatencyP99; }
+auto FrameTimingObject::frameInterval() const -> qreal { return d->frameInterval; }
+auto FrameTimingObject::frameIntervalP99() const -> qreal { return d->frameIntervalP99; }
+auto FrameTimingObject::vsyncInterval() const -> qreal { return d->vsyncInterval; }
+auto FrameTimingObject::judder() const -> qreal { return d->judder; }
+auto FrameTimingObject::cadenceBreaks() const -> qreal { return d->cadenceBreaks; }
+auto FrameTimingObject::renderHistogram() const -> QList<int> { return d->renderHistogram; }
+auto FrameTimingObject::vsyncHistogram() const -> QList<int> { return d->vsyncHistogram; }
+
+auto FrameTimingObject::gpuScopes() const -> QVariantMap
+{
+    QVariantMap map;
+    const auto results = OpenGLBenchmarker::instance().results();
+    for (int i = 0; i < results.size(); ++i) {
+        const auto &r = results[i];
+        QVariantMap scope;
+        scope[u"count"_q] = r.count;
+        scope[u"average"_q] = r.average;
+        scope[u"max"_q] = r.max;
+        map[_L(OpenGLBenchmarker::scopeName((OpenGLBenchmarker::Scope)i))] = scope;
+    }
+    return map;
+}
+
+QVariantMap FrameTimingObject::report() const
+{
+    QVariantMap map;
+    auto mo = metaObject();
+    for (int i = mo->propertyOffset(); i < mo->propertyCount(); ++i) {
+        const auto property = mo->property(i);
+        auto value = property.read(this);
+        if (value.userType() == qMetaTypeId<QList<int>>()) {
+            QVariantList list;
+            for (auto v : value.value<QList<int>>())
+                list.push_back(v);
+            value = list;
+        }
+        map[_L(property.name())] = value;
+    }
+    return map;
+}
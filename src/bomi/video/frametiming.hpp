@@ -0,0 +1,91 @@
+#ifndef FRAMETIMING_HPP
+#define FRAMETIMING_HPP
+
+#include "misc/lockfreering.hpp"
+
+// all values are in nanoseconds, -1 if not available
+struct FrameTimingSample {
+    qint64 start = 0;    // render start on monotonic clock
+    qint64 cpu = -1;     // render call duration on cpu
+    qint64 gpu = -1;     // render duration on gpu (timer query)
+    qint64 swap = -1;    // from render start to buffer swap
+    qint64 interval = -1;// from previous frame swap to this frame swap
+    qint64 vsync = -1;   // nominal refresh interval of the screen
+};
+
+using FrameTimingRing = LockFreeRing<FrameTimingSample, 1024>;
+
+// lives in render thread
+class FrameTimingRecorder {
+public:
+    FrameTimingRecorder();
+    ~FrameTimingRecorder();
+    auto initializeGL(qreal refreshRate) -> void;
+    auto finalizeGL() -> void;
+    auto begin() -> void;
+    auto end() -> void;
+    auto swapped() -> void;
+    auto samples() -> FrameTimingRing* { return &m_ring; }
+private:
+    auto flush() -> void;
+    struct Data;
+    Data *d;
+    FrameTimingRing m_ring;
+};
+
+// lives in gui thread and summarizes recent samples
+class FrameTimingObject : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(int samples READ samples NOTIFY statisticsChanged)
+    Q_PROPERTY(int droppedSamples READ droppedSamples NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal renderTime READ renderTime NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal renderTimeP95 READ renderTimeP95 NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal renderTimeP99 READ renderTimeP99 NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal renderTimeMax READ renderTimeMax NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal gpuTime READ gpuTime NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal gpuTimeP99 READ gpuTimeP99 NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal swapLatencyP99 READ swapLatencyP99 NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal frameInterval READ frameInterval NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal frameIntervalP99 READ frameIntervalP99 NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal vsyncInterval READ vsyncInterval NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal judder READ judder NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal cadenceBreaks READ cadenceBreaks NOTIFY statisticsChanged)
+    Q_PROPERTY(QList<int> renderHistogram READ renderHistogram NOTIFY statisticsChanged)
+    Q_PROPERTY(QList<int> vsyncHistogram READ vsyncHistogram NOTIFY statisticsChanged)
+    Q_PROPERTY(QVariantMap gpuScopes READ gpuScopes NOTIFY statisticsChanged)
+public:
+    // width of renderHistogram bins in ms; the last bin collects the rest
+    static constexpr int RenderBins = 33;
+    // vsyncHistogram[n] counts frames shown for n+1 refreshes
+    static constexpr int VsyncBins = 6;
+    FrameTimingObject();
+    ~FrameTimingObject();
+    auto samples() const -> int;
+    auto droppedSamples() const -> int;
+    auto renderTime() const -> qreal;
+    auto renderTimeP95() const -> qreal;
+    auto renderTimeP99() const -> qreal;
+    auto renderTimeMax() const -> qreal;
+    auto gpuTime() const -> qreal;
+    auto gpuTimeP99() const -> qreal;
+    auto swapLatencyP99() const -> qreal;
+    auto frameInterval() const -> qreal;
+    auto frameIntervalP99() const -> qreal;
+    auto vsyncInterval() const -> qreal;
+    auto judder() const -> qreal;
+    auto cadenceBreaks() const -> qreal;
+    auto renderHistogram() const -> QList<int>;
+    auto vsyncHistogram() const -> QList<int>;
+    // per-pass times from OpenGLBenchmarker: { name: { count, average, max } }
+    auto gpuScopes() const -> QVariantMap;
+    auto update(FrameTimingRing *ring) -> void;
+    Q_INVOKABLE void reset();
+    Q_INVOKABLE QVariantMap report() const;
+signals:
+    void statisticsChanged();
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // FRAMETIMING_HPP
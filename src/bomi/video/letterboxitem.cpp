@@ -4,6 +4,7 @@ LetterboxItem::LetterboxItem(QQuickItem *parent)
     : SimpleVertexItem(parent)
 {
     setColor(Qt::black);
+    setBenchmarkScope(OpenGLBenchmarker::Letterbox);
     vertices().resize(6*4);
 }
 
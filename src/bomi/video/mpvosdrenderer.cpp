@@ -1,6 +1,7 @@
 #include "mpvosdrenderer.hpp"
 #include "opengl/openglvertex.hpp"
 #include "opengl/opengltexturebinder.hpp"
+#include "opengl/openglbenchmarker.hpp"
 #include "tmp/static_op.hpp"
 #include <QOpenGLBuffer>
 extern "C" {
@@ -14,6 +15,67 @@ struct PartInfo {
     QPoint map = {0, 0};
     quint32 color = 0;
     int strideAsPixel = 0;
+    bool upload = false;
+};
+
+// identifies bitmap content regardless of its address
+struct AtlasKey {
+    uint hash = 0; int w = 0, h = 0;
+    auto operator == (const AtlasKey &rhs) const -> bool
+        { return hash == rhs.hash && w == rhs.w && h == rhs.h; }
+};
+
+SIA qHash(const AtlasKey &key, uint seed = 0) -> uint
+{ return qHash(key.hash, seed) ^ (key.w << 16) ^ key.h; }
+
+// second hash of a resident bitmap, independent of AtlasKey::hash, to
+// verify hits without keeping a copy of the bitmap
+struct AtlasEntry {
+    QPoint pos;
+    quint64 check = 0;
+    static auto checksum(const sub_bitmap &img, int rowBytes) -> quint64
+    {
+        // 64-bit FNV-1a over rows, which ignores padding of stride
+        quint64 h = Q_UINT64_C(14695981039346656037);
+        const auto src = static_cast<const uchar*>(img.bitmap);
+        for (int y = 0; y < img.h; ++y) {
+            const auto row = src + y * img.stride;
+            for (int x = 0; x < rowBytes; ++x)
+                h = (h ^ row[x]) * Q_UINT64_C(1099511628211);
+        }
+        return h;
+    }
+};
+
+// shelf packing: a rect goes to the first shelf which is tall enough but
+// not too tall, otherwise a new shelf is opened below. nothing is freed
+// individually; when the atlas is full, it is cleared at once.
+struct AtlasShelves {
+    struct Shelf { int y, height, x; };
+    auto reset(const QSize &size) -> void
+        { m_size = size; m_shelves.clear(); m_bottom = 0; }
+    auto allocate(int w, int h) -> QPoint
+    {
+        static constexpr int Padding = 1;
+        w += Padding; h += Padding;
+        for (auto &shelf : m_shelves) {
+            if (h <= shelf.height && h * 4 >= shelf.height * 3
+                    && shelf.x + w <= m_size.width()) {
+                const QPoint pos(shelf.x, shelf.y);
+                shelf.x += w;
+                return pos;
+            }
+        }
+        if (m_bottom + h > m_size.height() || w > m_size.width())
+            return {-1, -1};
+        m_shelves.push_back({m_bottom, h, w});
+        m_bottom += h;
+        return {0, m_shelves.back().y};
+    }
+private:
+    QSize m_size;
+    QVector<Shelf> m_shelves;
+    int m_bottom = 0;
 };
 
 struct MpvOsdRenderer::Data {
@@ -34,9 +96,12 @@ struct MpvOsdRenderer::Data {
     OpenGLTextureTransferInfo transfer;
     QMatrix4x4 vMatrix;
     QOpenGLBuffer vbo{QOpenGLBuffer::VertexBuffer};
-    int prevVboSize = 0;
+    int vboCapacity = 0;
+    QVector<Vertex> vertices;
     QOpenGLFunctions *func = nullptr;
     QVector<PartInfo> parts;
+    AtlasShelves shelves;
+    QHash<AtlasKey, AtlasEntry> resident;
 
     auto build(int inFormat) -> void
     {
@@ -44,6 +109,7 @@ struct MpvOsdRenderer::Data {
             return;
         _Renew(shader);
         atlasSize = {};
+        resident.clear();
         const auto tformat = format & SUBBITMAP_RGBA ? OGL::BGRA
                                                      : OGL::OneComponent;
         transfer = OpenGLTextureTransferInfo::get(tformat);
@@ -94,17 +160,46 @@ struct MpvOsdRenderer::Data {
         shader->setUniformValue(loc_atlas, 0);
         shader->release();
     }
+    auto resetAtlas(const QSize &size) -> void
+    {
+        if (_Change(atlasSize, size))
+            atlas.initialize(atlasSize, transfer);
+        shelves.reset(atlasSize);
+        resident.clear();
+    }
+    // returns false if some part cannot be placed in current atlas
+    auto place(const sub_bitmaps *imgs, const QVector<AtlasKey> &keys,
+               const QVector<quint64> &checks) -> bool
+    {
+        bool ok = true;
+        for (int i = 0; i < imgs->num_parts; ++i) {
+            auto &part = parts[i];
+            auto it = resident.find(keys[i]);
+            if (it != resident.end() && it->check == checks[i]) {
+                part.map = it->pos;
+                continue;
+            }
+            // on hash collision, the other bitmap is just not reused anymore
+            part.map = shelves.allocate(keys[i].w, keys[i].h);
+            if (part.map.x() < 0) {
+                ok = false;
+                continue;
+            }
+            part.upload = true;
+            resident.insert(keys[i], { part.map, checks[i] });
+        }
+        return ok;
+    }
     auto initializeAtlas(const sub_bitmaps *imgs) -> void
     {
-        using tmp::aligned;
         static const int max = OGL::maximumTextureSize();
         if (parts.size() < imgs->num_parts)
             _Expand(parts, imgs->num_parts);
         static constexpr int shifts[] = { 0, 0, 2, 2 };
         const int shift = shifts[imgs->format];
-        QSize sheet{0, 0}; QPoint map{0, 0};
-        int lineHeight = 0;
-
+        QVector<AtlasKey> keys(imgs->num_parts);
+        QVector<quint64> checks(imgs->num_parts);
+        qint64 area = 0;
         for (int i=0; i<imgs->num_parts; ++i) {
             auto &img = imgs->parts[i];
             auto &part = parts[i];
@@ -113,25 +208,32 @@ struct MpvOsdRenderer::Data {
                 part.color = (color & 0xffffff00) | (0xff - (color & 0xff));
             }
             part.strideAsPixel = (img.stride >> shift);
-            if (map.x() + part.strideAsPixel >= max) {
-                map.rx() = 0; map.ry() += lineHeight;
-                lineHeight = 0;
-            }
-            part.map = map;
-            if (img.h > lineHeight)
-                lineHeight = img.h;
-            if (map.x() + part.strideAsPixel > sheet.width())
-                sheet.rwidth() = map.x() + part.strideAsPixel;
-            map.rx() += img.w;
+            part.upload = false;
+            auto &key = keys[i];
+            key.w = img.w; key.h = img.h;
+            const auto bits = static_cast<const uchar*>(img.bitmap);
+            for (int y = 0; y < img.h; ++y)
+                key.hash = qHashBits(bits + y * img.stride, img.w << shift, key.hash);
+            checks[i] = AtlasEntry::checksum(img, img.w << shift);
+            area += (img.w + 1) * (img.h + 1);
         }
-        sheet.rheight() = map.y() + lineHeight;
 
-        if (sheet.width() > atlasSize.width() || sheet.height() > atlasSize.height()) {
-            if (sheet.width() > atlasSize.width())
-                atlasSize.rwidth() = qMin(aligned<4>(sheet.width()*1.5), max);
-            if (sheet.height() > atlasSize.height())
-                atlasSize.rheight() = qMin(aligned<4>(sheet.height()*1.5), max);
-            atlas.initialize(atlasSize, transfer);
+        if (atlasSize.isEmpty())
+            resetAtlas(QSize(qMin(1024, max), qMin(1024, max)));
+        if (place(imgs, keys, checks))
+            return;
+        // evict everything and pack current parts only, growing if needed
+        QSize size = atlasSize;
+        while (area * 2 > qint64(size.width()) * size.height()
+               && (size.width() < max || size.height() < max))
+            size = QSize(qMin(size.width() * 2, max), qMin(size.height() * 2, max));
+        forever {
+            resetAtlas(size);
+            for (int i = 0; i < imgs->num_parts; ++i)
+                parts[i].upload = false;
+            if (place(imgs, keys, checks) || (size.width() >= max && size.height() >= max))
+                break;
+            size = QSize(qMin(size.width() * 2, max), qMin(size.height() * 2, max));
         }
     }
 };
@@ -162,6 +264,7 @@ auto MpvOsdRenderer::prepare(OpenGLFramebufferObject *fbo) -> void
 {
     d->clear = true;
     d->fbo = fbo;
+    OpenGLBenchmarker::instance().begin(OpenGLBenchmarker::Osd);
 }
 
 SIA alignment(int stride) -> int
@@ -195,19 +298,28 @@ auto MpvOsdRenderer::draw(const sub_bitmaps *imgs) -> void
     if (_Change(d->last.id, imgs->change_id)) {
         d->build(imgs->format);
         d->initializeAtlas(imgs);
-        if (d->prevVboSize < static_cast<int>(num*6))
-            d->vbo.allocate((d->prevVboSize = num*6*1.2)*sizeof(Vertex));
-        auto vertex = static_cast<Vertex*>(d->vbo.map(QOpenGLBuffer::WriteOnly));
+        _Expand(d->vertices, num*6);
+        auto vertex = d->vertices.data();
         for (int i = 0; i < num; ++i) {
             const auto &part = d->parts[i];
             const auto &img = imgs->parts[i];
-            Q_ASSERT(part.map.x() + part.strideAsPixel <= d->atlas.width());
+            if (part.map.x() < 0) { // atlas is full even at maximum size
+                vertex = OGL::CoordAttr::fillTriangles(vertex,
+                    &Vertex::position, QPointF(), QPointF(),
+                    &Vertex::texCoord, QPointF(), QPointF(),
+                    [&](Vertex *const it) { it->color.set(0u); });
+                continue;
+            }
+            Q_ASSERT(part.map.x() + img.w <= d->atlas.width());
             Q_ASSERT(part.map.y() + img.h <= d->atlas.height());
 
-            glPixelStorei(GL_UNPACK_ALIGNMENT, alignment(img.stride));
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, part.strideAsPixel);
-
-            d->atlas.upload(part.map.x(), part.map.y(), img.w, img.h, img.bitmap);
+            if (part.upload) {
+                glPixelStorei(GL_UNPACK_ALIGNMENT, alignment(img.stride));
+                glPixelStorei(GL_UNPACK_ROW_LENGTH, part.strideAsPixel);
+                d->atlas.upload(part.map.x(), part.map.y(), img.w, img.h, img.bitmap);
+                glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            }
 
             QPointF tp = part.map; QSizeF ts(img.w, img.h);
             tp.rx() /= d->atlas.width();
@@ -219,11 +331,12 @@ auto MpvOsdRenderer::draw(const sub_bitmaps *imgs) -> void
                 &Vertex::position, pos.topLeft(), pos.bottomRight(),
                 &Vertex::texCoord, tex.topLeft(), tex.bottomRight(),
                 [&](Vertex *const it) { it->color.set(part.color); });
-
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         }
-        d->vbo.unmap();
+        // keep the buffer storage and only rewrite its contents
+        const int bytes = num*6*sizeof(Vertex);
+        if (d->vboCapacity < bytes)
+            d->vbo.allocate(d->vboCapacity = bytes*1.2);
+        d->vbo.write(0, d->vertices.constData(), bytes);
     }
 
     d->vMatrix.setToIdentity();
@@ -265,6 +378,7 @@ auto MpvOsdRenderer::end() -> void
         glClear(GL_COLOR_BUFFER_BIT);
         d->fbo->release();
     }
+    OpenGLBenchmarker::instance().end(OpenGLBenchmarker::Osd);
 }
 
 auto MpvOsdRenderer::callback(void *ctx, sub_bitmaps *imgs) -> void
@@ -0,0 +1,136 @@
+#include "videokeyframeindex.hpp"
+#include "misc/log.hpp"
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+DECLARE_LOG_CONTEXT(Video)
+
+struct VideoKeyframeIndex::Data {
+    VideoKeyframeIndex *p = nullptr;
+    QByteArray path;
+    mutable QMutex mutex;
+    QVector<qint64> keyframes;
+    qint64 duration = 0;
+    bool ready = false;
+    QAtomicInt quit;
+    // index of the first keyframe not less than time
+    auto lowerBound(qint64 time) const -> int
+    {
+        return std::lower_bound(keyframes.begin(), keyframes.end(), time)
+                - keyframes.begin();
+    }
+};
+
+VideoKeyframeIndex::VideoKeyframeIndex(QObject *parent)
+    : QThread(parent), d(new Data)
+{
+    d->p = this;
+}
+
+VideoKeyframeIndex::~VideoKeyframeIndex()
+{
+    unload();
+    delete d;
+}
+
+auto VideoKeyframeIndex::load(const QByteArray &path) -> void
+{
+    unload();
+    d->path = path;
+    d->quit = false;
+    start(QThread::LowestPriority);
+}
+
+auto VideoKeyframeIndex::unload() -> void
+{
+    d->quit = true;
+    wait();
+    QMutexLocker locker(&d->mutex);
+    d->keyframes.clear();
+    d->duration = 0;
+    d->ready = false;
+}
+
+auto VideoKeyframeIndex::isReady() const -> bool
+{
+    QMutexLocker locker(&d->mutex);
+    return d->ready;
+}
+
+auto VideoKeyframeIndex::duration() const -> qint64
+{
+    QMutexLocker locker(&d->mutex);
+    return d->duration;
+}
+
+auto VideoKeyframeIndex::snap(qint64 time) const -> qint64
+{
+    QMutexLocker locker(&d->mutex);
+    if (d->keyframes.isEmpty())
+        return time;
+    const int idx = d->lowerBound(time);
+    if (idx >= d->keyframes.size())
+        return d->keyframes.last();
+    if (idx > 0 && time - d->keyframes[idx - 1] < d->keyframes[idx] - time)
+        return d->keyframes[idx - 1];
+    return d->keyframes[idx];
+}
+
+auto VideoKeyframeIndex::neighbors(qint64 time, int direction,
+                                   int count) const -> QVector<qint64>
+{
+    QMutexLocker locker(&d->mutex);
+    QVector<qint64> ret;
+    if (d->keyframes.isEmpty() || !direction)
+        return ret;
+    int idx = d->lowerBound(time);
+    if (direction > 0 && idx < d->keyframes.size() && d->keyframes[idx] == time)
+        ++idx;
+    else if (direction < 0)
+        --idx;
+    for (; ret.size() < count && _InRange0(idx, d->keyframes.size()); idx += direction)
+        ret.push_back(d->keyframes[idx]);
+    return ret;
+}
+
+auto VideoKeyframeIndex::run() -> void
+{
+    auto format = avformat_alloc_context();
+    format->interrupt_callback.callback = [] (void *data) -> int
+        { return static_cast<Data*>(data)->quit; };
+    format->interrupt_callback.opaque = d;
+    // format is freed by avformat_open_input() on failure
+    if (avformat_open_input(&format, d->path.constData(), nullptr, nullptr) < 0)
+        return;
+    if (format->duration == AV_NOPTS_VALUE)
+        avformat_find_stream_info(format, nullptr);
+    const int stream = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO,
+                                           -1, -1, nullptr, 0);
+    QVector<qint64> keyframes;
+    if (stream >= 0 && !d->quit) {
+        const auto st = format->streams[stream];
+        const auto start = format->start_time == AV_NOPTS_VALUE
+                ? 0 : av_rescale_q(format->start_time, AV_TIME_BASE_Q, st->time_base);
+        keyframes.reserve(st->nb_index_entries);
+        for (int i = 0; i < st->nb_index_entries; ++i) {
+            const auto &entry = st->index_entries[i];
+            if (entry.flags & AVINDEX_KEYFRAME)
+                keyframes.push_back(av_rescale_q(entry.timestamp - start,
+                                                 st->time_base, {1, 1000}));
+        }
+        std::sort(keyframes.begin(), keyframes.end());
+        keyframes.erase(std::unique(keyframes.begin(), keyframes.end()),
+                        keyframes.end());
+    }
+    const auto duration = format->duration == AV_NOPTS_VALUE
+            ? 0 : av_rescale_q(format->duration, AV_TIME_BASE_Q, {1, 1000});
+    avformat_close_input(&format);
+    if (d->quit)
+        return;
+    _Debug("Keyframe index built: %% keyframes in %%ms", keyframes.size(), duration);
+    QMutexLocker locker(&d->mutex);
+    d->keyframes = std::move(keyframes);
+    d->duration = duration;
+    d->ready = duration > 0;
+}
@@ -0,0 +1,21 @@
+#ifndef VIDEOKEYFRAMEINDEX_HPP
+#define VIDEOKEYFRAMEINDEX_HPP
+
+class VideoKeyframeIndex : public QThread {
+public:
+    VideoKeyframeIndex(QObject *parent = nullptr);
+    ~VideoKeyframeIndex();
+    auto load(const QByteArray &path) -> void;
+    auto unload() -> void;
+    auto isReady() const -> bool;
+    auto duration() const -> qint64;
+    // all times are in milliseconds from the start of file
+    auto snap(qint64 time) const -> qint64;
+    auto neighbors(qint64 time, int direction, int count) const -> QVector<qint64>;
+private:
+    auto run() -> void final;
+    struct Data;
+    Data *d;
+};
+
+#endif // VIDEOKEYFRAMEINDEX_HPP
@@ -1,4 +1,6 @@
 #include "videopreview.hpp"
+#include "videothumbnailcache.hpp"
+#include "videokeyframeindex.hpp"
 #include "opengl/opengltexture2d.hpp"
 #include "opengl/openglframebufferobject.hpp"
 #include "opengl/opengltexturebinder.hpp"
@@ -6,19 +8,44 @@
 #include "misc/log.hpp"
 #include "player/mpv.hpp"
 #include <QQuickWindow>
+#include <QElapsedTimer>
 
 DECLARE_LOG_CONTEXT(Video)
 
-enum EventType {NewFrame = QEvent::User + 1 };
+enum EventType {NewFrame = QEvent::User + 1, SeekDone, Captured };
+
+static constexpr const int PrefetchCount = 2;
+static constexpr const int MaxFrames = 24;
+static constexpr const int SeekTimeout = 1000;
+
+struct PreviewRequest {
+    qint64 key = -1; // keyframe in msec
+    double percent = -1;
+    bool prefetch = false;
+    auto isValid() const -> bool { return key >= 0 || percent >= 0; }
+};
 
 struct VideoPreview::Data {
     VideoPreview *p = nullptr;
     int id = 0;
     bool redraw = false, active = false, keyframe = true, video = false;
-    bool loaded = false;
+    bool loaded = false, live = true, display = true;
     QSize displaySize{0, 0};
     double rate = 0.0, aspect = 0, percent = 0;
+    int slot = -1, direction = 0;
+    qint64 shown = -1;
     Mpv mpv;
+    VideoThumbnailCache cache;
+    VideoKeyframeIndex index;
+    QImage thumbnail;
+    PreviewRequest inFlight, pending, capture;
+    QElapsedTimer sent;
+    // decoded keyframes stay in gpu memory; frames are created and deleted
+    // by paint() while gui thread is blocked, evicted ones wait in garbage
+    QMap<qint64, OpenGLFramebufferObject*> frames;
+    QList<qint64> recent;
+    QVector<OpenGLFramebufferObject*> garbage;
+    qint64 recalled = -1;
     auto vo() const -> QByteArray { return "opengl-cb"_b; }
     auto hasVideo() -> bool { return id > 0 && !displaySize.isEmpty(); }
     auto sizeAspect() const -> double
@@ -27,6 +54,134 @@ struct VideoPreview::Data {
             return 0;
         return displaySize.width()/(double)displaySize.height();
     }
+    auto forget(qint64 key) -> void
+    {
+        if (auto frame = frames.take(key))
+            garbage.push_back(frame);
+        recent.removeOne(key);
+    }
+    auto recall(qint64 key) -> bool
+    {
+        const auto frame = frames.value(key);
+        if (!frame)
+            return false;
+        if (frame->size() != p->imageSize()) {
+            forget(key);
+            return false;
+        }
+        recent.removeOne(key);
+        recent.push_back(key);
+        return true;
+    }
+    auto remember(qint64 key, OpenGLFramebufferObject *frame) -> void
+    {
+        forget(key);
+        if (frames.size() >= MaxFrames)
+            forget(recent.first());
+        recent.push_back(key);
+        frames[key] = frame;
+    }
+    auto collect() -> void
+    {
+        qDeleteAll(garbage);
+        garbage.clear();
+    }
+    auto send(const PreviewRequest &req) -> void
+    {
+        inFlight = req;
+        display = !req.prefetch;
+        sent.restart();
+        if (req.key >= 0)
+            mpv.tellAsync("seek", req.key * 1e-3, "absolute+keyframes"_b);
+        else
+            mpv.tellAsync("seek", req.percent, keyframe
+                          ? "absolute-percent+keyframes"_b
+                          : "absolute-percent+exact"_b);
+    }
+    // only one seek is in flight, later requests replace the pending one
+    auto request(const PreviewRequest &req) -> void
+    {
+        if (inFlight.isValid() && !sent.hasExpired(SeekTimeout))
+            pending = req;
+        else
+            send(req);
+    }
+    auto dispatch() -> void
+    {
+        inFlight = PreviewRequest();
+        if (pending.isValid()) {
+            send(pending);
+            pending = PreviewRequest();
+        } else if (keyframe && index.isReady() && direction) {
+            const auto from = index.snap(rate * index.duration());
+            for (auto key : index.neighbors(from, direction, PrefetchCount)) {
+                if (!frames.contains(key)) {
+                    PreviewRequest req;
+                    req.key = key;
+                    req.prefetch = true;
+                    send(req);
+                    break;
+                }
+            }
+        }
+    }
+    auto target() const -> const PreviewRequest*
+    {
+        if (pending.isValid())
+            return &pending;
+        if (inFlight.isValid() && !inFlight.prefetch)
+            return &inFlight;
+        return nullptr;
+    }
+    auto seek() -> void
+    {
+        PreviewRequest req;
+        if (keyframe && index.isReady())
+            req.key = index.snap(rate * index.duration());
+        else
+            req.percent = percent;
+        const int slot = cache.slot(rate);
+        if (req.key >= 0) {
+            const auto t = target();
+            if (t ? t->key == req.key : shown == req.key)
+                return;
+        } else if (!live && slot == this->slot)
+            return;
+        this->slot = slot;
+        const bool stored = keyframe && recall(req.key);
+        QImage image;
+        // rows of cached thumbnail are top-down unlike fbo filled by mpv
+        if (!stored && keyframe)
+            image = cache.thumbnail(rate).mirrored();
+        if (stored || !image.isNull()) {
+            pending = PreviewRequest();
+            live = false;
+            recalled = stored ? req.key : -1;
+            thumbnail = image;
+            shown = req.key;
+            redraw = true;
+            p->reserve(UpdateMaterial);
+        } else {
+            live = true;
+            recalled = -1;
+            thumbnail = QImage();
+            request(req);
+        }
+    }
+    auto reset() -> void
+    {
+        inFlight = pending = capture = PreviewRequest();
+        for (auto frame : frames)
+            garbage.push_back(frame);
+        frames.clear();
+        recent.clear();
+        recalled = -1;
+        thumbnail = QImage();
+        live = display = true;
+        slot = -1;
+        shown = -1;
+        direction = 0;
+    }
 };
 
 VideoPreview::VideoPreview(QQuickItem *parent)
@@ -38,6 +193,7 @@ VideoPreview::VideoPreview(QQuickItem *parent)
     setFlag(ItemAcceptsDrops, true);
 
     d->mpv.setLogContext("mpv/preview"_b);
+    d->mpv.setBenchmarkScope(OpenGLBenchmarker::Preview);
 
     d->mpv.create();
 
@@ -48,6 +204,7 @@ VideoPreview::VideoPreview(QQuickItem *parent)
     });
     d->mpv.request(MPV_EVENT_START_FILE, [=] () { d->loaded = true; });
     d->mpv.request(MPV_EVENT_END_FILE, [=] () { d->loaded = false; });
+    d->mpv.request(MPV_EVENT_PLAYBACK_RESTART, [=] () { _PostEvent(this, SeekDone); });
     d->mpv.setOption("hwdec", "no");
     d->mpv.setOption("aid", "no");
     d->mpv.setOption("sid", "no");
@@ -83,6 +240,8 @@ auto VideoPreview::initializeGL() -> void
 auto VideoPreview::finalizeGL() -> void
 {
     Super::finalizeGL();
+    d->reset();
+    d->collect();
     d->mpv.finalizeGL();
 }
 
@@ -95,11 +254,12 @@ auto VideoPreview::setRate(double rate) -> void
 {
     if (!d->active || !d->video || !d->loaded)
         return;
+    const auto prev = d->rate;
     if (_Change(d->rate, rate)) {
-        if (_Change(d->percent, qRound(d->rate * 10000)/100.0))
-            d->mpv.tellAsync("seek", d->percent, d->keyframe
-                             ? "absolute-percent+keyframes"_b
-                             : "absolute-percent+exact"_b);
+        if (_Change(d->percent, qRound(d->rate * 10000)/100.0)) {
+            d->direction = d->rate < prev ? -1 : 1;
+            d->seek();
+        }
         emit rateChanged(d->rate);
     }
 }
@@ -113,10 +273,26 @@ auto VideoPreview::customEvent(QEvent *event) -> void
 {
     switch (static_cast<int>(event->type())) {
     case NewFrame: {
+        if (!d->live || !d->display)
+            break;
         d->redraw = true;
         reserve(UpdateMaterial);
         break;
-    } default:
+    } case SeekDone: {
+        if (!d->inFlight.isValid())
+            break;
+        if (!d->inFlight.prefetch && d->live)
+            d->shown = d->inFlight.key;
+        if (d->inFlight.key >= 0 && isVisible() && window()) {
+            d->capture = d->inFlight;
+            reserve(UpdateMaterial);
+        } else
+            d->dispatch();
+        break;
+    } case Captured:
+        d->dispatch();
+        break;
+    default:
         d->mpv.process(event);
         break;
     }
@@ -147,34 +323,72 @@ auto VideoPreview::sizeHint() const -> QSize
 
 auto VideoPreview::paint(OpenGLFramebufferObject *fbo) -> void
 {
+    d->collect();
     fbo->bind();
     if (d->redraw) {
         d->redraw = false;
         auto w = window();
-        if (w) {
+        if (auto frame = d->frames.value(d->recalled)) {
+            if (frame->size() == fbo->size()) {
+                auto texture = fbo->texture();
+                OpenGLTextureBinder<OGL::Target2D> binder(&texture);
+                frame->bind();
+                glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0,
+                                    fbo->width(), fbo->height());
+                fbo->bind();
+            }
+        } else if (!d->thumbnail.isNull()) {
+            const auto image = d->thumbnail.scaled(fbo->size(),
+                Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            auto texture = fbo->texture();
+            OpenGLTextureBinder<OGL::Target2D> binder(&texture);
+            texture.upload(image.constBits());
+        } else if (w) {
             w->resetOpenGLState();
             d->mpv.render(fbo, nullptr, QMargins());
             w->resetOpenGLState();
         }
     }
     fbo->release();
+    if (d->capture.isValid()) {
+        // keep decoded keyframes so that revisiting them needs no seek;
+        // they are never read back to avoid stalling render thread
+        if (auto w = window()) {
+            auto frame = new OpenGLFramebufferObject(fbo->size());
+            w->resetOpenGLState();
+            d->mpv.render(frame, nullptr, QMargins());
+            w->resetOpenGLState();
+            d->remember(d->capture.key, frame);
+        }
+        d->capture = PreviewRequest();
+        _PostEvent(this, Captured);
+    }
 }
 
 auto VideoPreview::load(const QByteArray &path) -> void
 {
     if (path.contains("bomi-yle-"_b))
         return;
-    if (d->active)
+    if (d->active) {
+        d->reset();
         d->mpv.tellAsync("loadfile", path);
+        d->cache.load(path);
+        d->index.load(path);
+    }
 }
 
 auto VideoPreview::unload() -> void
 {
     d->mpv.tellAsync("stop");
+    d->cache.unload();
+    d->index.unload();
+    d->reset();
 }
 
 auto VideoPreview::shutdown() -> void
 {
+    d->cache.unload();
+    d->index.unload();
     d->mpv.tellAsync("quit");
 }
 
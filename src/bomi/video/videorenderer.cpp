@@ -1,14 +1,17 @@
 #include "videorenderer.hpp"
 #include "letterboxitem.hpp"
 #include "mpvosdrenderer.hpp"
+#include "frametiming.hpp"
 #include "opengl/opengltexture2d.hpp"
 #include "opengl/openglframebufferobject.hpp"
 #include "opengl/opengltexturebinder.hpp"
+#include "opengl/openglbenchmarker.hpp"
 #include "misc/dataevent.hpp"
 #include "misc/log.hpp"
 #include "enum/rotation.hpp"
 #include <QQmlProperty>
 #include <QQuickWindow>
+#include <QScreen>
 
 DECLARE_LOG_CONTEXT(Video)
 
@@ -151,6 +154,8 @@ struct VideoRenderer::Data {
     QSize sourceSize{0, 1};
     QTimer sizeChecker;
     RenderFrameFunc render = nullptr;
+    FrameTimingRecorder timing;
+    QMetaObject::Connection swapped;
 
     static auto isSameRatio(double r1, double r2) -> bool
         {return (r1 < 0.0 && r2 < 0.0) || qFuzzyCompare(r1, r2);}
@@ -277,6 +282,11 @@ auto VideoRenderer::setRenderFrameFunction(const RenderFrameFunc &func) -> void
     d->render = func;
 }
 
+auto VideoRenderer::frameTimingSamples() const -> FrameTimingRing*
+{
+    return d->timing.samples();
+}
+
 auto VideoRenderer::updateForNewFrame(const QSize &displaySize) -> void
 {
     _PostEvent(Qt::HighEventPriority, this, NewFrame, displaySize);
@@ -305,11 +315,21 @@ auto VideoRenderer::initializeGL() -> void
     const quint32 p = 0x0;
     d->frame.fallback.initialize(1, 1, OGL::BGRA, &p);
     d->osd.fallback = d->frame.fallback;
+    OpenGLBenchmarker::instance().create();
+    auto w = window();
+    d->timing.initializeGL(w->screen() ? w->screen()->refreshRate() : 0.0);
+    d->swapped = connect(w, &QQuickWindow::frameSwapped, this, [=] () {
+        OpenGLBenchmarker::instance().collect();
+        d->timing.swapped();
+    }, Qt::DirectConnection);
 }
 
 auto VideoRenderer::finalizeGL() -> void
 {
     Super::finalizeGL();
+    disconnect(d->swapped);
+    d->timing.finalizeGL();
+    OpenGLBenchmarker::instance().destroy();
     d->frame.fallback.destroy();
     _Delete(d->frame.fbo);
 }
@@ -521,7 +541,9 @@ auto VideoRenderer::render(VideoShaderData *data) -> void
     auto w = window();
     if (w && d->render) {
         w->resetOpenGLState();
+        d->timing.begin();
         d->render(d->frame.fbo, data->osdVisible ? d->osd.fbo : nullptr, data->osdMargins);
+        d->timing.end();
         w->resetOpenGLState();
     }
 }
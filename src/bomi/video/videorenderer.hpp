@@ -7,6 +7,9 @@
 #include <functional>
 
 class OpenGLFramebufferObject;          enum class Rotation;
+struct FrameTimingSample;
+template<class T, int N> class LockFreeRing;
+using FrameTimingRing = LockFreeRing<FrameTimingSample, 1024>;
 using Fbo = OpenGLFramebufferObject;
 using RenderFrameFunc = std::function<void(Fbo*,Fbo*,const QMargins&)>;
 
@@ -60,6 +63,8 @@ public:
     auto setScalerEnabled(bool on) -> void;
     auto setOsdVisible(bool visible) -> void;
     auto updateAll() -> void;
+    // filled in render thread, drained by FrameTimingObject
+    auto frameTimingSamples() const -> FrameTimingRing*;
     Q_INVOKABLE QRectF mapFromVideo(const QRect &rect);
 signals:
     void offsetChanged(const QPointF &pos);
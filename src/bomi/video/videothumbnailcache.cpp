@@ -0,0 +1,357 @@
+#include "videothumbnailcache.hpp"
+#include "misc/log.hpp"
+#include "tmp/static_op.hpp"
+#include <QCryptographicHash>
+#include <QLockFile>
+#include <QPointer>
+#include <libmpv/client.h>
+
+DECLARE_LOG_CONTEXT(Video)
+
+static constexpr const int ThumbnailHeight = 144;
+static constexpr const qint64 DiskBudget = 256*1024*1024;
+static constexpr const quint32 StoreVersion = 1;
+static const QByteArray StoreMagic = "bomithmb"_b;
+
+// on-disk layout: header, padding up to pixelOffset(), Count*height*stride
+// RGB888 pixels. filled[i] is set only after slot i has been written.
+struct ThumbnailHeader {
+    char magic[8];
+    quint32 version, count, width, height, stride, reserved;
+    quint8 filled[VideoThumbnailCache::Count];
+};
+
+SCIA pixelOffset() -> int { return tmp::aligned<16>(sizeof(ThumbnailHeader)); }
+
+class VideoThumbnailCache::Worker : public QThread {
+public:
+    QByteArray path;
+    QString fileName;
+    mutable QMutex mutex;
+    QFile store;
+    uchar *map = nullptr;
+    QAtomicInt quitting;
+    mpv_handle *handle = nullptr;
+    QScopedPointer<QLockFile> lock;
+    bool started = false;
+
+    ~Worker() { close(); }
+
+    auto stop() -> void
+    {
+        QMutexLocker locker(&mutex);
+        quitting = true;
+        if (handle)
+            mpv_wakeup(handle);
+    }
+    auto header() const -> ThumbnailHeader*
+        { return reinterpret_cast<ThumbnailHeader*>(map); }
+    auto slotSize() const -> qint64
+        { return qint64(header()->stride) * header()->height; }
+    auto pixels(int slot) const -> uchar*
+        { return map + pixelOffset() + slot * slotSize(); }
+    auto partName() const -> QString { return fileName % ".part"_a; }
+    auto close() -> void
+    {
+        if (map)
+            store.unmap(map);
+        map = nullptr;
+        store.close();
+    }
+    auto open(const QString &name, QIODevice::OpenMode mode) -> bool
+    {
+        close();
+        store.setFileName(name);
+        if (!store.open(mode))
+            return false;
+        if (store.size() >= pixelOffset())
+            map = store.map(0, store.size());
+        auto h = header();
+        if (h && !memcmp(h->magic, StoreMagic.constData(), 8)
+                && h->version == StoreVersion && h->count == Count
+                && store.size() == pixelOffset() + Count * slotSize())
+            return true;
+        close();
+        return false;
+    }
+    auto create(const QString &name, const QImage &image) -> bool
+    {
+        close();
+        store.setFileName(name);
+        if (!store.open(QFile::ReadWrite | QFile::Truncate))
+            return false;
+        ThumbnailHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, StoreMagic.constData(), 8);
+        h.version = StoreVersion;
+        h.count = Count;
+        h.width = image.width();
+        h.height = image.height();
+        h.stride = image.bytesPerLine();
+        store.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        if (store.resize(pixelOffset() + Count * qint64(h.stride) * h.height))
+            map = store.map(0, store.size());
+        if (map)
+            return true;
+        close();
+        store.remove();
+        return false;
+    }
+    auto prune() -> void
+    {
+        QDir dir(directory());
+        const auto list = dir.entryInfoList({ u"*.thumb"_q, u"*.thumb.part"_q },
+                                            QDir::Files, QDir::Time);
+        qint64 total = 0;
+        for (auto &info : list) {
+            total += info.size();
+            if (total > DiskBudget && !info.filePath().startsWith(fileName))
+                QFile::remove(info.filePath());
+        }
+    }
+private:
+    auto run() -> void final;
+};
+
+struct VideoThumbnailCache::Data {
+    QPointer<Worker> worker;
+    // workers told to quit but possibly still in a blocking mpv call
+    QList<QPointer<Worker>> retired;
+};
+
+VideoThumbnailCache::VideoThumbnailCache(QObject *parent)
+    : QObject(parent), d(new Data)
+{
+}
+
+VideoThumbnailCache::~VideoThumbnailCache()
+{
+    unload();
+    // only place where workers are joined, which is on exit
+    for (auto &worker : d->retired) {
+        if (worker) {
+            worker->wait();
+            delete worker;
+        }
+    }
+    delete d;
+}
+
+auto VideoThumbnailCache::directory() -> QString
+{
+    const auto dir = _WritablePath(Location::Cache) % "/thumbnails"_a;
+    QDir().mkpath(dir);
+    return dir;
+}
+
+auto VideoThumbnailCache::load(const QByteArray &path) -> void
+{
+    unload();
+    const QFileInfo info(QString::fromUtf8(path));
+    if (!info.isFile())
+        return;
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    auto w = new Worker;
+    d->worker = w;
+    w->path = path;
+    w->fileName = directory() % '/'_q % _L(hash.result().toHex()) % ".thumb"_a;
+
+    QMutexLocker locker(&w->mutex);
+    if (w->open(w->fileName, QFile::ReadOnly))
+        return;
+    w->lock.reset(new QLockFile(w->fileName % ".lock"_a));
+    if (!w->lock->tryLock(0)) {
+        _Debug("Thumbnails for %% are being extracted by other process.", path);
+        w->lock.reset();
+        return;
+    }
+    w->open(w->partName(), QFile::ReadWrite);
+    w->quitting = false;
+    w->started = true;
+    QPointer<Worker> guard(w);
+    connect(w, &QThread::finished, this, [=] () {
+        if (guard && guard != d->worker)
+            guard->deleteLater();
+    });
+    w->start(QThread::LowestPriority);
+}
+
+auto VideoThumbnailCache::unload() -> void
+{
+    auto w = d->worker.data();
+    d->worker.clear();
+    if (!w)
+        return;
+    if (!w->started || w->isFinished()) {
+        delete w;
+        return;
+    }
+    // worker is deleted after finished(), once its mpv call returns
+    w->stop();
+    d->retired.removeAll(nullptr);
+    d->retired.push_back(w);
+}
+
+auto VideoThumbnailCache::slot(double rate) const -> int
+{
+    return qBound(0, static_cast<int>(rate * Count), Count - 1);
+}
+
+auto VideoThumbnailCache::thumbnail(double rate) const -> QImage
+{
+    auto w = d->worker.data();
+    if (!w)
+        return QImage();
+    QMutexLocker locker(&w->mutex);
+    const int slot = this->slot(rate);
+    if (!w->map || !w->header()->filled[slot])
+        return QImage();
+    const auto h = w->header();
+    return QImage(w->pixels(slot), h->width, h->height, h->stride,
+                  QImage::Format_RGB888).convertToFormat(QImage::Format_ARGB32);
+}
+
+auto VideoThumbnailCache::Worker::run() -> void
+{
+    prune();
+    auto handle = mpv_create();
+    auto set = [&] (const char *name, const char *value)
+        { mpv_set_option_string(handle, name, value); };
+    set("config", "no");
+    set("input-terminal", "no");
+    set("quiet", "yes");
+    set("vo", "null");
+    set("ao", "null");
+    set("aid", "no");
+    set("sid", "no");
+    set("audio-file-auto", "no");
+    set("sub-auto", "no");
+    set("hwdec", "no");
+    set("osd-level", "0");
+    set("pause", "yes");
+    set("keep-open", "always");
+    set("hr-seek", "no");
+    set("vd-lavc-skiploopfilter", "all");
+    set("vd-lavc-fast", "yes");
+    if (mpv_initialize(handle) < 0) {
+        mpv_terminate_destroy(handle);
+        return;
+    }
+    {
+        QMutexLocker locker(&mutex);
+        handle = handle;
+    }
+    auto wait = [&] (mpv_event_id id) -> bool {
+        forever {
+            const auto event = mpv_wait_event(handle, -1)->event_id;
+            if (quitting || _IsOneOf(event, MPV_EVENT_SHUTDOWN, MPV_EVENT_END_FILE))
+                return false;
+            if (event == id)
+                return true;
+        }
+    };
+    auto capture = [&] () -> QImage {
+        mpv_node args[2], result;
+        args[0].format = args[1].format = MPV_FORMAT_STRING;
+        args[0].u.string = const_cast<char*>("screenshot-raw");
+        args[1].u.string = const_cast<char*>("video");
+        mpv_node_list list = { 2, args, nullptr };
+        mpv_node cmd;
+        cmd.format = MPV_FORMAT_NODE_ARRAY;
+        cmd.u.list = &list;
+        if (mpv_command_node(handle, &cmd, &result) < 0)
+            return QImage();
+        int w = 0, h = 0, stride = 0; mpv_byte_array *data = nullptr;
+        if (result.format == MPV_FORMAT_NODE_MAP) {
+            for (int i = 0; i < result.u.list->num; ++i) {
+                const auto key = result.u.list->keys[i];
+                const auto &value = result.u.list->values[i];
+                if (value.format == MPV_FORMAT_INT64) {
+                    if (!qstrcmp(key, "w"))
+                        w = value.u.int64;
+                    else if (!qstrcmp(key, "h"))
+                        h = value.u.int64;
+                    else if (!qstrcmp(key, "stride"))
+                        stride = value.u.int64;
+                } else if (value.format == MPV_FORMAT_BYTE_ARRAY
+                           && !qstrcmp(key, "data"))
+                    data = value.u.ba;
+            }
+        }
+        QImage image;
+        if (data && w > 0 && h > 0 && stride * h <= (int)data->size) {
+            // bgr0 is QImage::Format_RGB32 in native byte order
+            const QImage frame(static_cast<const uchar*>(data->data),
+                               w, h, stride, QImage::Format_RGB32);
+            image = frame.scaledToHeight(qMin(h, ThumbnailHeight),
+                                         Qt::SmoothTransformation)
+                         .convertToFormat(QImage::Format_RGB888);
+        }
+        mpv_free_node_contents(&result);
+        return image;
+    };
+
+    const char *load[] = { "loadfile", path.constData(), nullptr };
+    mpv_command(handle, load);
+    bool ok = wait(MPV_EVENT_FILE_LOADED) && wait(MPV_EVENT_PLAYBACK_RESTART);
+
+    // coarse to fine so that the whole range gets covered quickly
+    QVector<int> order; QVector<bool> queued(Count, false);
+    for (int step = 64; step > 0; step /= 2) {
+        for (int i = 0; i < Count; i += step) {
+            if (!queued[i]) {
+                queued[i] = true;
+                order.push_back(i);
+            }
+        }
+    }
+
+    for (int i = 0; ok && i < order.size(); ++i) {
+        const int slot = order[i];
+        {
+            QMutexLocker locker(&mutex);
+            if (map && header()->filled[slot])
+                continue;
+        }
+        const auto percent = QByteArray::number((slot + 0.5) * 100.0 / Count);
+        const char *seek[] = { "seek", percent.constData(),
+                               "absolute-percent+keyframes", nullptr };
+        if (mpv_command(handle, seek) < 0 || !wait(MPV_EVENT_PLAYBACK_RESTART))
+            break;
+        auto image = capture();
+        if (image.isNull()) {
+            ok = map;
+            continue;
+        }
+        QMutexLocker locker(&mutex);
+        if (!map && !(ok = create(partName(), image)))
+            break;
+        const auto h = header();
+        if (image.size() != QSize(h->width, h->height))
+            image = image.scaled(h->width, h->height, Qt::IgnoreAspectRatio,
+                                 Qt::SmoothTransformation);
+        for (quint32 y = 0; y < h->height; ++y)
+            memcpy(pixels(slot) + y * h->stride, image.constScanLine(y),
+                   qMin<int>(h->stride, image.bytesPerLine()));
+        h->filled[slot] = 1;
+    }
+
+    {
+        QMutexLocker locker(&mutex);
+        handle = nullptr;
+    }
+    mpv_terminate_destroy(handle);
+
+    QMutexLocker locker(&mutex);
+    if (!ok || quitting || !map)
+        return;
+    close();
+    QFile::remove(fileName);
+    if (QFile::rename(partName(), fileName)) {
+        open(fileName, QFile::ReadOnly);
+        _Debug("Thumbnails extracted: %%", fileName);
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef VIDEOTHUMBNAILCACHE_HPP
+#define VIDEOTHUMBNAILCACHE_HPP
+
+// Extraction runs in a worker per file, which is never joined on unload:
+// it is told to quit and deletes itself once its current mpv call returns.
+class VideoThumbnailCache : public QObject {
+public:
+    static constexpr int Count = 100;
+    VideoThumbnailCache(QObject *parent = nullptr);
+    ~VideoThumbnailCache();
+    auto load(const QByteArray &path) -> void;
+    auto unload() -> void;
+    // returns null image if the slot for rate is not extracted yet
+    auto thumbnail(double rate) const -> QImage;
+    auto slot(double rate) const -> int;
+    static auto directory() -> QString;
+private:
+    class Worker;
+    struct Data;
+    Data *d;
+};
+
+#endif // VIDEOTHUMBNAILCACHE_HPP